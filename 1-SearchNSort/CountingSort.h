@@ -0,0 +1,281 @@
+#pragma once
+
+#include "KeyCounts.h"
+#include "SearchNSort.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+ * Counting sort and histograms for integral keys from a bounded range.
+ *
+ * A histogram of the keys, with one counter per value in [min, max], is
+ * all the keys-only sort needs: it rewrites the array from the counts and
+ * never scatters keys. The key+payload sort also rebuilds the keys from
+ * the counts, and moves each payload to its place using running offsets,
+ * which keeps it stable.
+ *
+ * Counting sort costs O(n + max - min), so every sort falls back to
+ * SearchNSort<K>::mergeSort() when the range is too wide for the number of
+ * keys (see worthwhile()), or when a key lies outside a caller-supplied
+ * range.
+ *
+ * Histograms can be counted on several threads, so programs using this
+ * header need -pthread. The single-threaded pieces, such as range(),
+ * trySort(), and worthwhile(), come from KeyCounts.
+ */
+template <class K> class CountingSort : public KeyCounts<K> {
+public:
+  /**
+   * Count how often each value in [min, max] occurs in an array.
+   *
+   * \param pKeys Pointer to the first key to count.
+   * \param n Number of keys.
+   * \param min Smallest value to count.
+   * \param max Largest value to count.
+   * \param pCounts Destination for max - min + 1 counters;
+   * pCounts[i] receives the number of keys equal to min + i.
+   * \param threads Number of threads to count with; 0 means one per
+   * hardware thread. Small arrays are always counted on one thread.
+   * \return true if every key was in [min, max], false otherwise; keys
+   * outside the range are not counted. Also false, without touching
+   * pCounts, if max < min or [min, max] holds more than maxCounters
+   * values.
+   */
+  static bool histogram(const K *pKeys, unsigned n, K min, K max,
+                        unsigned *pCounts, unsigned threads = 1u);
+
+  /**
+   * Sort an array of keys, finding their range first.
+   *
+   * \param pKeys Pointer to the first key to sort.
+   * \param n Number of keys.
+   * \param threads Number of threads for the histogram; see histogram().
+   * \return true if the keys were counting sorted, false if the range was
+   * too wide and they were sorted with mergeSort() instead.
+   */
+  static bool sort(K *pKeys, unsigned n, unsigned threads = 1u);
+
+  /**
+   * Sort an array of keys from a known range.
+   *
+   * \param pKeys Pointer to the first key to sort.
+   * \param n Number of keys.
+   * \param min Smallest possible key.
+   * \param max Largest possible key.
+   * \param threads Number of threads for the histogram; see histogram().
+   * \return true if the keys were counting sorted, false if the range was
+   * too wide or held too few keys, and they were sorted with mergeSort()
+   * instead.
+   */
+  static bool sort(K *pKeys, unsigned n, K min, K max,
+                   unsigned threads = 1u);
+
+  /**
+   * Stably sort an array of keys and a parallel array of payloads,
+   * finding the key range first.
+   *
+   * \param pKeys Pointer to the first key to sort.
+   * \param pPayload Pointer to the payload for the first key; pPayload[i]
+   * moves along with pKeys[i].
+   * \param n Number of keys.
+   * \param threads Number of threads for the histogram; see histogram().
+   * \return true if the keys were counting sorted, false if the range was
+   * too wide and a stable comparison sort was used instead.
+   */
+  template <class P>
+  static bool sort(K *pKeys, P *pPayload, unsigned n, unsigned threads = 1u);
+
+  /**
+   * Stably sort an array of keys from a known range and a parallel array
+   * of payloads.
+   *
+   * \param pKeys Pointer to the first key to sort.
+   * \param pPayload Pointer to the payload for the first key; pPayload[i]
+   * moves along with pKeys[i].
+   * \param n Number of keys.
+   * \param min Smallest possible key.
+   * \param max Largest possible key.
+   * \param threads Number of threads for the histogram; see histogram().
+   * \return true if the keys were counting sorted, false if the range was
+   * too wide or held too few keys, and a stable comparison sort was used
+   * instead.
+   */
+  template <class P>
+  static bool sort(K *pKeys, P *pPayload, unsigned n, K min, K max,
+                   unsigned threads = 1u);
+};
+
+/*
+ * Implementation of histogram() function.
+ */
+template <class K>
+bool CountingSort<K>::histogram(const K *pKeys, unsigned n, K min, K max,
+                                unsigned *pCounts, unsigned threads) {
+
+  // a span of 0 means the whole 64-bit range
+  unsigned long long values = KeyCounts<K>::span(min, max);
+  if (max < min || values == 0ull || values > KeyCounts<K>::maxCounters) {
+    return false;
+  }
+
+  const unsigned nCounts = values;
+  std::fill(pCounts, pCounts + nCounts, 0u);
+
+  // give each thread at least 64K keys, so starting it pays off; check
+  // that before asking how many hardware threads there are, which is slow
+  const unsigned minPerThread = 1u << 16;
+  const unsigned mostThreads = n / minPerThread;
+  if (threads == 0u && mostThreads >= 2u) {
+    threads = std::thread::hardware_concurrency();
+  }
+  if (threads > mostThreads) {
+    threads = mostThreads;
+  }
+  if (threads < 2u) {
+    return KeyCounts<K>::count(pKeys, n, min, max, pCounts);
+  }
+
+  // each thread counts one slice into its own histogram
+  std::vector<std::vector<unsigned>> counts(threads);
+  std::vector<char> inRange(threads);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0u; t < threads; t++) {
+    unsigned lo = (unsigned long long)n * t / threads;
+    unsigned hi = (unsigned long long)n * (t + 1u) / threads;
+    workers.push_back(std::thread([=, &counts, &inRange]() {
+      counts[t].assign(nCounts, 0u);
+      inRange[t] = KeyCounts<K>::count(pKeys + lo, hi - lo, min, max,
+                                       counts[t].data());
+    }));
+  }
+
+  bool allInRange = true;
+  for (unsigned t = 0u; t < threads; t++) {
+    workers[t].join();
+    allInRange = allInRange && inRange[t];
+    for (unsigned i = 0u; i < nCounts; i++) {
+      pCounts[i] += counts[t][i];
+    }
+  }
+  return allInRange;
+}
+
+/*
+ * Implementation of keys-only sort() function with automatic range.
+ */
+template <class K>
+bool CountingSort<K>::sort(K *pKeys, unsigned n, unsigned threads) {
+
+  if (n < 2u) {
+    return true;
+  }
+
+  K min, max;
+  KeyCounts<K>::range(pKeys, n, min, max);
+  return sort(pKeys, n, min, max, threads);
+}
+
+/*
+ * Implementation of keys-only sort() function.
+ */
+template <class K>
+bool CountingSort<K>::sort(K *pKeys, unsigned n, K min, K max,
+                           unsigned threads) {
+
+  if (max < min || !KeyCounts<K>::worthwhile(min, max, n)) {
+    SearchNSort<K>::mergeSort(pKeys, n, SearchNSort<K>::ascending);
+    return false;
+  }
+
+  std::vector<unsigned> counts(KeyCounts<K>::span(min, max));
+  if (!histogram(pKeys, n, min, max, counts.data(), threads)) {
+    SearchNSort<K>::mergeSort(pKeys, n, SearchNSort<K>::ascending);
+    return false;
+  }
+
+  KeyCounts<K>::write(pKeys, counts.data(), counts.size(), min);
+  return true;
+}
+
+/*
+ * Implementation of key+payload sort() function with automatic range.
+ */
+template <class K>
+template <class P>
+bool CountingSort<K>::sort(K *pKeys, P *pPayload, unsigned n,
+                           unsigned threads) {
+
+  if (n < 2u) {
+    return true;
+  }
+
+  K min, max;
+  KeyCounts<K>::range(pKeys, n, min, max);
+  return sort(pKeys, pPayload, n, min, max, threads);
+}
+
+/*
+ * Implementation of key+payload sort() function.
+ */
+template <class K>
+template <class P>
+bool CountingSort<K>::sort(K *pKeys, P *pPayload, unsigned n, K min, K max,
+                           unsigned threads) {
+
+  std::vector<unsigned> counts;
+  bool counted = max >= min && KeyCounts<K>::worthwhile(min, max, n);
+  if (counted) {
+    counts.resize(KeyCounts<K>::span(min, max));
+    counted = histogram(pKeys, n, min, max, counts.data(), threads);
+  }
+
+  if (!counted) {
+    // stable comparison sort of positions, then gather
+    std::vector<unsigned> order(n);
+    for (unsigned i = 0u; i < n; i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [pKeys](unsigned x, unsigned y) {
+                       return pKeys[x] < pKeys[y];
+                     });
+
+    std::vector<K> keys(n);
+    std::vector<P> payload(n);
+    for (unsigned i = 0u; i < n; i++) {
+      keys[i] = pKeys[order[i]];
+      payload[i] = pPayload[order[i]];
+    }
+    std::copy(keys.begin(), keys.end(), pKeys);
+    std::copy(payload.begin(), payload.end(), pPayload);
+    return false;
+  }
+
+  // turn counts into the starting position of each value
+  unsigned offset = 0u;
+  for (unsigned i = 0u; i < counts.size(); i++) {
+    unsigned c = counts[i];
+    counts[i] = offset;
+    offset += c;
+  }
+
+  // payloads move in input order, which keeps equal keys stable
+  std::vector<P> payload(n);
+  for (unsigned i = 0u; i < n; i++) {
+    unsigned bucket = static_cast<unsigned long long>(pKeys[i]) -
+                      static_cast<unsigned long long>(min);
+    payload[counts[bucket]++] = pPayload[i];
+  }
+  std::copy(payload.begin(), payload.end(), pPayload);
+
+  // counts[i] is now where value i ends, so keys can be rebuilt in place;
+  // each value is worked out from min so the last one can't overflow
+  unsigned start = 0u;
+  for (unsigned i = 0u; i < counts.size(); i++) {
+    K key = static_cast<K>(static_cast<unsigned long long>(min) + i);
+    std::fill(pKeys + start, pKeys + counts[i], key);
+    start = counts[i];
+  }
+  return true;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "SortProfile.h"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Single-threaded counting sort for integral keys from a bounded range.
+ *
+ * This is the part of CountingSort that SearchNSort<T>::sort() needs, kept
+ * apart so that including SearchNSort.h doesn't pull in threads.
+ * CountingSort builds its threaded histograms and key+payload sorts on
+ * top of it.
+ */
+template <class K> struct KeyCounts {
+  static_assert(std::is_integral<K>::value, "KeyCounts needs integer keys");
+
+  /**
+   * Add up how often each value in [min, max] occurs in an array, on the
+   * calling thread.
+   *
+   * \param pKeys Pointer to the first key to count.
+   * \param n Number of keys.
+   * \param min Smallest value to count.
+   * \param max Largest value to count.
+   * \param pCounts max - min + 1 counters; pCounts[i] is increased by the
+   * number of keys equal to min + i.
+   * \return true if every key was in [min, max], false otherwise; keys
+   * outside the range are not counted.
+   */
+  static bool count(const K *pKeys, unsigned n, K min, K max,
+                    unsigned *pCounts);
+
+  /**
+   * Find the smallest and largest keys in an array.
+   *
+   * \param pKeys Pointer to the first key to check.
+   * \param n Number of keys; must be at least 1.
+   * \param min Receives the smallest key.
+   * \param max Receives the largest key.
+   */
+  static void range(const K *pKeys, unsigned n, K &min, K &max);
+
+  /**
+   * Get the number of values in [min, max].
+   *
+   * \param min Smallest value.
+   * \param max Largest value; must be at least min.
+   * \return max - min + 1, or 0 for the whole 64-bit range.
+   */
+  static unsigned long long span(K min, K max) {
+    return static_cast<unsigned long long>(max) -
+           static_cast<unsigned long long>(min) + 1ull;
+  }
+
+  /**
+   * Counting sort an array only if a quick look says it pays off: a sample
+   * of the keys must span a narrow enough range before the exact range is
+   * computed. Used by SearchNSort<K>::sort().
+   *
+   * \param pKeys Pointer to the first key to sort.
+   * \param n Number of keys; must be at least 2.
+   * \return true if the keys were sorted, false if they were left alone.
+   */
+  static bool trySort(K *pKeys, unsigned n);
+
+  /**
+   * Determine if counting sort beats a comparison sort for a key range.
+   * The range may be at most SortProfile::countingRangeFactor times the
+   * number of keys, plus 256, and at most maxCounters values.
+   *
+   * \param min Smallest key.
+   * \param max Largest key.
+   * \param n Number of keys.
+   * \return true if counting sort should be used, false otherwise.
+   */
+  static bool worthwhile(K min, K max, unsigned n);
+
+  /**
+   * Rewrite an array of keys from their histogram, each value as many
+   * times as it was counted.
+   *
+   * \param pKeys Pointer to the first key to write.
+   * \param pCounts Counters from count(); pCounts[i] is the number of
+   * keys equal to min + i.
+   * \param nCounts Number of counters.
+   * \param min Smallest value counted.
+   */
+  static void write(K *pKeys, const unsigned *pCounts, unsigned nCounts,
+                    K min);
+
+  /**
+   * Largest number of counters a histogram may use.
+   */
+  static const unsigned maxCounters = 1u << 24;
+};
+
+/*
+ * Implementation of count() function.
+ */
+template <class K>
+bool KeyCounts<K>::count(const K *pKeys, unsigned n, K min, K max,
+                         unsigned *pCounts) {
+
+  bool inRange = true;
+  for (unsigned i = 0u; i < n; i++) {
+    if (pKeys[i] < min || pKeys[i] > max) {
+      inRange = false;
+    } else {
+      pCounts[static_cast<unsigned long long>(pKeys[i]) -
+              static_cast<unsigned long long>(min)]++;
+    }
+  }
+  return inRange;
+}
+
+/*
+ * Implementation of range() function.
+ */
+template <class K>
+void KeyCounts<K>::range(const K *pKeys, unsigned n, K &min, K &max) {
+
+  K lo = pKeys[0], hi = pKeys[0];
+  for (unsigned i = 1u; i < n; i++) {
+    lo = pKeys[i] < lo ? pKeys[i] : lo;
+    hi = pKeys[i] > hi ? pKeys[i] : hi;
+  }
+  min = lo;
+  max = hi;
+}
+
+/*
+ * Implementation of trySort() function.
+ */
+template <class K> bool KeyCounts<K>::trySort(K *pKeys, unsigned n) {
+
+  // a sample that is already too spread out rules counting sort out
+  // without reading the whole array
+  const unsigned samples = n < 64u ? n : 64u;
+  K lo = pKeys[0], hi = pKeys[0];
+  for (unsigned k = 1u; k < samples; k++) {
+    const K &key = pKeys[(unsigned long long)k * (n - 1u) / (samples - 1u)];
+    lo = key < lo ? key : lo;
+    hi = key > hi ? key : hi;
+  }
+  if (!worthwhile(lo, hi, n)) {
+    return false;
+  }
+
+  K min, max;
+  range(pKeys, n, min, max);
+  if (!worthwhile(min, max, n)) {
+    return false;
+  }
+
+  std::vector<unsigned> counts(span(min, max));
+  count(pKeys, n, min, max, counts.data());
+  write(pKeys, counts.data(), counts.size(), min);
+  return true;
+}
+
+/*
+ * Implementation of worthwhile() function.
+ */
+template <class K> bool KeyCounts<K>::worthwhile(K min, K max, unsigned n) {
+
+  unsigned long long values = span(min, max);
+
+  // a span of 0 means the whole 64-bit range
+  if (values == 0ull || values > maxCounters) {
+    return false;
+  }
+  return values <= SortProfile::active().countingRangeFactor * n + 256.0;
+}
+
+/*
+ * Implementation of write() function.
+ */
+template <class K>
+void KeyCounts<K>::write(K *pKeys, const unsigned *pCounts, unsigned nCounts,
+                         K min) {
+
+  // each value is worked out from min, since stepping a key past the last
+  // counter would overflow when max is the largest K
+  for (unsigned i = 0u; i < nCounts; i++) {
+    K key = static_cast<K>(static_cast<unsigned long long>(min) + i);
+    pKeys = std::fill_n(pKeys, pCounts[i], key);
+  }
+}
+
+/*
+ * Counting sort shortcut for SearchNSort<T>::sort(), only available for
+ * integral types other than bool.
+ */
+template <class T, bool = std::is_integral<T>::value &&
+                          !std::is_same<T, bool>::value>
+struct IntegerKeys {
+  static bool trySort(T *, unsigned) { return false; }
+};
+
+template <class T> struct IntegerKeys<T, true> {
+  static bool trySort(T *pArr, unsigned n) {
+    return KeyCounts<T>::trySort(pArr, n);
+  }
+};
@@ -0,0 +1,435 @@
+#pragma once
+
+#include "SearchNSort.h"
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Sort that runs in bounded slices, for callers that can't block for a
+ * whole sort.
+ *
+ * Each call to step() does a limited amount of work and returns; all the
+ * state needed to carry on lives in the object, so nothing recurses and
+ * no single call does more than its budget (plus at most one sorting
+ * network leaf). Work is measured in operations, roughly one per
+ * comparison or element moved, or in wall-clock time.
+ *
+ * The quicksort keeps an explicit stack of ranges still to sort and
+ * partitions one comparison at a time. It always works on the leftmost
+ * unsorted range, so the array fills in with final values from the left,
+ * and finalized() grows as it goes. It pivots on the median of the first,
+ * middle, and last elements, so presorted input doesn't go quadratic.
+ * Small ranges of arithmetic types are finished by sorting networks.
+ *
+ * The mergesort is a bottom-up, stable merge sort that merges one element
+ * at a time. Like SearchNSort::mergeSort(), it starts from sorting network
+ * runs only for arithmetic types sorted with ascending(), since networks
+ * don't keep equal elements in order. Nothing is final until the last
+ * pass, which writes the array from the left.
+ */
+template <class T> class ResumableSort {
+public:
+  /**
+   * Algorithms a ResumableSort can run.
+   */
+  enum Algorithm { QUICK, MERGE };
+
+  /**
+   * Prepare to sort an array. No sorting happens until step() is called.
+   *
+   * \param pArr Pointer to the first element of the array to sort. It
+   * must stay valid, and must not be touched by anything else, until the
+   * sort is done.
+   * \param n Size of the array.
+   * \param compare Pointer to function used to compare two elements;
+   * must return negative if x < y, zero if x == y, or positive if
+   * x > y.
+   * \param algorithm Algorithm to use.
+   */
+  ResumableSort(T *pArr, unsigned n, int (*compare)(const T &x, const T &y),
+                Algorithm algorithm = QUICK);
+
+  /**
+   * Determine if the array is sorted.
+   *
+   * \return true if the sort is complete, false otherwise.
+   */
+  bool done() const { return finished; }
+
+  /**
+   * Get the length of the prefix that already holds its final, sorted
+   * values.
+   *
+   * \return Number of leading elements that won't change again.
+   */
+  unsigned finalized() const;
+
+  /**
+   * Get the number of operations performed so far.
+   *
+   * \return Operations counted over all step() calls.
+   */
+  unsigned long long operations() const { return ops; }
+
+  /**
+   * Estimate how much of the sort is complete.
+   *
+   * \return Fraction in [0, 1]: the share of elements sorted into place
+   * for QUICK, the share of total merge work done for MERGE.
+   */
+  double progress() const;
+
+  /**
+   * Do at most about budget operations of sorting.
+   *
+   * \param budget Number of operations to do before returning.
+   * \return true if the sort is complete, false otherwise.
+   */
+  bool step(unsigned long long budget);
+
+  /**
+   * Sort for about the given time, then return. The clock is checked
+   * every 256 operations.
+   *
+   * \param budget Time to spend before returning.
+   * \return true if the sort is complete, false otherwise.
+   */
+  bool step(std::chrono::nanoseconds budget);
+
+private:
+  /**
+   * Range of the array, pArr[lo, hi] inclusive.
+   */
+  struct Range {
+    int lo, hi;
+  };
+
+  /**
+   * Sort a small range with a sorting network and charge for it.
+   *
+   * \param pA Pointer to the first element of the range.
+   * \param size Size of the range; at most maxNetworkSize.
+   * \param budget Remaining budget, reduced by the cost of the sort.
+   */
+  void sortLeaf(T *pA, unsigned size, unsigned long long &budget);
+
+  /**
+   * Advance the mergesort within a budget.
+   *
+   * \param budget Remaining budget; reduced as work is done.
+   */
+  void stepMerge(unsigned long long &budget);
+
+  /**
+   * Advance the quicksort within a budget.
+   *
+   * \param budget Remaining budget; reduced as work is done.
+   */
+  void stepQuick(unsigned long long &budget);
+
+  T *pArr;
+  unsigned n;
+  int (*compare)(const T &x, const T &y);
+  Algorithm algorithm;
+  unsigned leafSize;
+  unsigned long long ops;
+  bool finished;
+
+  // quicksort: ranges still to sort, leftmost on top, and the state of the
+  // partition in progress. phase 0 scans i right, 1 scans j left, 2 swaps
+  std::vector<Range> ranges;
+  bool partitioning;
+  Range part;
+  int i, j, phase;
+  T pivot;
+  unsigned sortedCount;
+
+  // mergesort: current run width and position, the merge in progress,
+  // and which buffer holds the runs. When the number of passes is odd,
+  // the leaf runs are built in scratch so the last pass writes into pArr
+  std::vector<T> scratch;
+  unsigned passes, passesDone, width, pos, mid, end, mi, mj, mk;
+  bool merging, leaves, inScratch;
+};
+
+/*
+ * Implementation of ResumableSort constructor.
+ */
+template <class T>
+ResumableSort<T>::ResumableSort(T *pA, unsigned size,
+                                int (*comp)(const T &x, const T &y),
+                                Algorithm alg)
+    : pArr(pA), n(size), compare(comp), algorithm(alg), ops(0ull),
+      finished(size < 2u), partitioning(false), i(0), j(0), phase(0),
+      pivot(), sortedCount(0u), passes(0u), passesDone(0u), width(0u),
+      pos(0u), mid(0u), end(0u), mi(0u), mj(0u), mk(0u), merging(false),
+      leaves(true), inScratch(false) {
+
+  leafSize = SearchNSort<T>::smallSortCutoff < maxNetworkSize
+                 ? SearchNSort<T>::smallSortCutoff
+                 : maxNetworkSize;
+  // like SearchNSort, networks are only for arithmetic types, and MERGE
+  // only uses them where they can't change the order of equal elements
+  if (leafSize < 1u || !std::is_arithmetic<T>::value ||
+      (algorithm == MERGE && !NaturalOrder<T>::is(compare))) {
+    leafSize = 1u;
+  }
+
+  if (finished) {
+    return;
+  }
+
+  if (algorithm == QUICK) {
+    Range all = {0, (int)n - 1};
+    ranges.push_back(all);
+  } else {
+    scratch.resize(n);
+    for (unsigned runs = (n + leafSize - 1u) / leafSize; runs > 1u;
+         runs = (runs + 1u) / 2u) {
+      passes++;
+    }
+    inScratch = passes % 2u == 1u;
+  }
+}
+
+/*
+ * Implementation of finalized() function.
+ */
+template <class T> unsigned ResumableSort<T>::finalized() const {
+
+  if (finished) {
+    return n;
+  }
+
+  if (algorithm == QUICK) {
+    // everything left of the leftmost unsorted range is final
+    if (partitioning) {
+      return part.lo;
+    }
+    return ranges.empty() ? n : ranges.back().lo;
+  }
+
+  // only the last pass, which merges into pArr from the left, is final
+  if (!leaves && passesDone + 1u == passes && merging) {
+    return mk;
+  }
+  return 0u;
+}
+
+/*
+ * Implementation of progress() function.
+ */
+template <class T> double ResumableSort<T>::progress() const {
+
+  if (finished) {
+    return 1.0;
+  }
+
+  if (algorithm == QUICK) {
+    return (double)sortedCount / n;
+  }
+
+  double work =
+      leaves ? pos : n + (double)passesDone * n + (merging ? mk : pos);
+  return work / ((double)n * (passes + 1u));
+}
+
+/*
+ * Implementation of private sortLeaf() helper function.
+ */
+template <class T>
+void ResumableSort<T>::sortLeaf(T *pA, unsigned size,
+                                unsigned long long &budget) {
+
+  if (NaturalOrder<T>::is(compare)) {
+    NaturalOrder<T>::sortNetwork(pA, size);
+  } else {
+    CompareExchange<T> cx = {compare};
+    sortNetwork(pA, size, cx);
+  }
+
+  // a network does about size * log2(size) compare-exchanges
+  unsigned long long cost =
+      (unsigned long long)size * (networkLog2(size) + 1u);
+  ops += cost;
+  budget = budget > cost ? budget - cost : 0ull;
+}
+
+/*
+ * Implementation of operation-budget step() function.
+ */
+template <class T> bool ResumableSort<T>::step(unsigned long long budget) {
+
+  if (!finished) {
+    if (algorithm == QUICK) {
+      stepQuick(budget);
+    } else {
+      stepMerge(budget);
+    }
+  }
+  return finished;
+}
+
+/*
+ * Implementation of time-budget step() function.
+ */
+template <class T>
+bool ResumableSort<T>::step(std::chrono::nanoseconds budget) {
+
+  auto deadline = std::chrono::steady_clock::now() + budget;
+  while (!step(256ull) && std::chrono::steady_clock::now() < deadline)
+    ; // empty loop body
+
+  return finished;
+}
+
+/*
+ * Implementation of private stepMerge() helper function.
+ */
+template <class T>
+void ResumableSort<T>::stepMerge(unsigned long long &budget) {
+
+  while (budget > 0ull && !finished) {
+    if (leaves) {
+      // sort the next run of leafSize elements where the first pass
+      // expects to find it
+      unsigned size = n - pos < leafSize ? n - pos : leafSize;
+      T *pRun = pArr + pos;
+      if (inScratch) {
+        std::copy(pRun, pRun + size, scratch.data() + pos);
+        pRun = scratch.data() + pos;
+        ops += size;
+        budget = budget > size ? budget - size : 0ull;
+      }
+      sortLeaf(pRun, size, budget);
+
+      pos += size;
+      if (pos >= n) {
+        leaves = false;
+        finished = passes == 0u;
+        width = leafSize;
+        pos = 0u;
+      }
+      continue;
+    }
+
+    T *pSrc = inScratch ? scratch.data() : pArr;
+    T *pDst = inScratch ? pArr : scratch.data();
+
+    if (!merging) {
+      // start merging pSrc[pos, mid) and pSrc[mid, end) into pDst
+      mid = n - pos < width ? n : pos + width;
+      end = n - mid < width ? n : mid + width;
+      mi = pos;
+      mj = mid;
+      mk = pos;
+      merging = true;
+    }
+
+    // same element-at-a-time merge as SearchNSort::merge(), stable
+    while (budget > 0ull && mk < end) {
+      if (mi < mid && (mj >= end || compare(pSrc[mi], pSrc[mj]) <= 0)) {
+        pDst[mk++] = pSrc[mi++];
+      } else {
+        pDst[mk++] = pSrc[mj++];
+      }
+      ops++;
+      budget--;
+    }
+
+    if (mk == end) {
+      merging = false;
+      pos = end;
+      if (pos >= n) {
+        // pass complete; the runs are twice as wide and change buffers
+        passesDone++;
+        width *= 2u;
+        pos = 0u;
+        inScratch = !inScratch;
+        finished = passesDone == passes;
+      }
+    }
+  }
+}
+
+/*
+ * Implementation of private stepQuick() helper function.
+ */
+template <class T>
+void ResumableSort<T>::stepQuick(unsigned long long &budget) {
+
+  while (budget > 0ull && !finished) {
+    if (!partitioning) {
+      if (ranges.empty()) {
+        finished = true;
+        return;
+      }
+
+      Range r = ranges.back();
+      ranges.pop_back();
+
+      unsigned size = r.hi - r.lo + 1;
+      if (size <= leafSize) {
+        sortLeaf(pArr + r.lo, size, budget);
+        sortedCount += size;
+        continue;
+      }
+
+      // median of three goes to pArr[lo] to be the pivot
+      int m = r.lo + (r.hi - r.lo) / 2;
+      if (compare(pArr[m], pArr[r.lo]) < 0) {
+        std::swap(pArr[m], pArr[r.lo]);
+      }
+      if (compare(pArr[r.hi], pArr[m]) < 0) {
+        std::swap(pArr[r.hi], pArr[m]);
+        if (compare(pArr[m], pArr[r.lo]) < 0) {
+          std::swap(pArr[m], pArr[r.lo]);
+        }
+      }
+      std::swap(pArr[r.lo], pArr[m]);
+      ops += 3u;
+      budget = budget > 3u ? budget - 3u : 0ull;
+
+      pivot = pArr[r.lo];
+      part = r;
+      i = r.lo - 1;
+      j = r.hi + 1;
+      phase = 0;
+      partitioning = true;
+    }
+
+    // same Hoare partition as SearchNSort::partition(), one comparison
+    // at a time
+    while (budget > 0ull && partitioning) {
+      if (phase == 0) {
+        ops++;
+        budget--;
+        if (compare(pArr[++i], pivot) >= 0) {
+          phase = 1;
+        }
+      } else if (phase == 1) {
+        ops++;
+        budget--;
+        if (compare(pArr[--j], pivot) <= 0) {
+          phase = 2;
+        }
+      } else if (i >= j) {
+        // j splits the range; sort the left part first
+        Range right = {j + 1, part.hi};
+        Range left = {part.lo, j};
+        ranges.push_back(right);
+        ranges.push_back(left);
+        partitioning = false;
+      } else {
+        std::swap(pArr[i], pArr[j]);
+        phase = 0;
+      }
+    }
+  }
+
+  // don't make the caller come back just to find the stack empty
+  finished = finished || (!partitioning && ranges.empty());
+}
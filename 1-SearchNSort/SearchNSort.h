@@ -1,4 +1,13 @@
+#pragma once
+
+#include "KeyCounts.h"
+#include "SimdMerge.h"
+#include "SortProfile.h"
+#include "SortingNetwork.h"
+#include <algorithm>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 /**
  * Templated class with functions for searching and sorting.
@@ -6,6 +15,17 @@
 
 template <class T> class SearchNSort {
 public:
+  /**
+   * Compare two elements by their natural ordering, using the <
+   * operator. Sorts called with this function as their comparison take
+   * branchless shortcuts for arithmetic types.
+   *
+   * \param x First element to compare.
+   * \param y Second element to compare.
+   * \return negative if x < y, zero if x == y, or positive if x > y.
+   */
+  static int ascending(const T &x, const T &y) { return (y < x) - (x < y); }
+
   /**
    * Perform a binary search on an array.
    *
@@ -74,7 +94,10 @@ public:
                         int (*compare)(const T &x, const T &y));
 
   /**
-   * Sort an array using a quicksort algorithm.
+   * Sort an array using a quicksort algorithm. The pivot is a median of
+   * three; ranges that still recurse more than 2 log2(n) levels deep
+   * because the pivots keep landing near the ends are finished with
+   * mergeSort(), so the sort stays O(n log n).
    *
    * \param pArr Pointer to the first element of the array to sort.
    * \param n Size of the array.
@@ -85,7 +108,11 @@ public:
   static void quickSort(T *pArr, unsigned n,
                         int (*compare)(const T &x, const T &y)) {
 
-    quickSort(pArr, 0, n - 1, compare);
+    unsigned depth = 0u;
+    for (unsigned m = n; m > 1u; m /= 2u) {
+      depth += 2u;
+    }
+    quickSort(pArr, 0, n - 1, compare, depth);
   }
 
   /**
@@ -100,7 +127,102 @@ public:
   static void selectionSort(T *pArr, unsigned n,
                             int (*compare)(const T &x, const T &y));
 
+  /**
+   * Ranges of at most this many arithmetic elements are finished by a
+   * sorting network instead of further recursion in quickSort(), and in
+   * mergeSort() when sorting with ascending(). Values over maxNetworkSize
+   * act as maxNetworkSize; values under 2 turn the networks off. Other
+   * types always recurse, since copying them costs more than a network
+   * saves.
+   */
+  static unsigned smallSortCutoff;
+
+  /**
+   * Sort an array with whichever algorithm suits it best. A small sample
+   * of neighbouring elements tells presorted input from random input, and
+   * a second sample judges how many keys are duplicates; array size and
+   * whether compare is ascending() do the rest. Integers sorted with
+   * ascending() whose keys span a narrow range are counting sorted. The
+   * thresholds come from SortProfile::active(). The sort is not stable.
+   *
+   * \param pArr Pointer to the first element of the array to sort.
+   * \param n Size of the array.
+   * \param compare Pointer to function used to compare two elements;
+   * must return negative if x < y, zero if x == y, or positive if
+   * x > y.
+   */
+  static void sort(T *pArr, unsigned n,
+                   int (*compare)(const T &x, const T &y));
+
+  /**
+   * Sort an array of exactly N elements, N <= maxNetworkSize, in
+   * ascending order using the < operator. The sorting network is
+   * generated at compile time and has no data-dependent branches.
+   *
+   * \param pArr Pointer to the first element of the array to sort.
+   */
+  template <unsigned N> static void sortSmall(T *pArr) {
+    static_assert(N <= maxNetworkSize, "no sorting network that large");
+    SortingNetwork<N>::apply(pArr, MinMaxExchange());
+  }
+
+  /**
+   * Sort an array of exactly N elements, N <= maxNetworkSize, using a
+   * sorting network generated at compile time. The network is not
+   * stable.
+   *
+   * \param pArr Pointer to the first element of the array to sort.
+   * \param compare Pointer to function used to compare two elements;
+   * must return negative if x < y, zero if x == y, or positive if
+   * x > y.
+   */
+  template <unsigned N>
+  static void sortSmall(T *pArr, int (*compare)(const T &x, const T &y)) {
+    static_assert(N <= maxNetworkSize, "no sorting network that large");
+    CompareExchange<T> cx = {compare};
+    SortingNetwork<N>::apply(pArr, cx);
+  }
+
 private:
+  /**
+   * Determine if a comparison function is ascending() on an arithmetic
+   * type, which allows branchless shortcuts.
+   *
+   * \param compare Pointer to comparison function to check.
+   * \return true if the shortcuts apply, false otherwise.
+   */
+  static bool isNatural(int (*compare)(const T &x, const T &y));
+
+  /**
+   * Determine if an array is in order.
+   *
+   * \param pArr Pointer to the first element of the array to check.
+   * \param n Size of the array.
+   * \param compare Pointer to function used to compare two elements;
+   * must return negative if x < y, zero if x == y, or positive if
+   * x > y.
+   * \param descending true to check for descending order, false for
+   * ascending order.
+   * \return true if no neighbouring elements are out of order.
+   */
+  static bool isOrdered(const T *pArr, unsigned n,
+                        int (*compare)(const T &x, const T &y),
+                        bool descending);
+
+  /**
+   * Get the largest range size the recursive sorts hand to sortLeaf().
+   *
+   * \return smallSortCutoff, capped at maxNetworkSize, for arithmetic
+   * types; 1 for anything else.
+   */
+  static unsigned leafSize() {
+    if (!std::is_arithmetic<T>::value) {
+      return 1u;
+    }
+    return smallSortCutoff < maxNetworkSize ? smallSortCutoff
+                                            : maxNetworkSize;
+  }
+
   /**
    * Merge two sorted portions of an array into another.
    *
@@ -157,9 +279,77 @@ private:
    * \param compare Pointer to function used to compare two elements;
    * must return negative if x < y, zero if x == y, or positive if
    * x > y.
+   * \param depth Number of levels left before the range is handed to
+   * mergeSort().
    */
   static void quickSort(T *pArr, int lo, int hi,
-                        int (*compare)(const T &x, const T &y));
+                        int (*compare)(const T &x, const T &y),
+                        unsigned depth);
+
+  /**
+   * Estimate how presorted an array is from a sample of neighbouring
+   * pairs spread evenly across it.
+   *
+   * \param pArr Pointer to the first element of the array to sample.
+   * \param n Size of the array; must be at least 2.
+   * \param compare Pointer to function used to compare two elements;
+   * must return negative if x < y, zero if x == y, or positive if
+   * x > y.
+   * \return Fraction of sampled pairs that are out of order: 0 for
+   * sorted input, about 0.5 for random input, 1 for reversed input.
+   */
+  static double sampleDescents(const T *pArr, unsigned n,
+                               int (*compare)(const T &x, const T &y));
+
+  /**
+   * Estimate how many duplicate keys an array holds by sorting a sample
+   * of up to 64 elements spread evenly across it. Arrays under 32
+   * elements aren't sampled.
+   *
+   * \param pArr Pointer to the first element of the array to sample.
+   * \param n Size of the array.
+   * \param compare Pointer to function used to compare two elements;
+   * must return negative if x < y, zero if x == y, or positive if
+   * x > y.
+   * \return Fraction of neighbours in the sorted sample that are equal: 0
+   * for distinct keys, near 1 for very few distinct keys.
+   */
+  static double sampleDuplicates(const T *pArr, unsigned n,
+                                 int (*compare)(const T &x, const T &y));
+
+  /**
+   * Base case helper for the recursive sorts and sort(): sort a range
+   * with the sorting network for its size, or with insertionSort() for
+   * non-arithmetic types.
+   *
+   * \param pArr Pointer to first element of the range to sort.
+   * \param n Size of the range; must be at most maxNetworkSize.
+   * \param compare Pointer to function used to compare two elements;
+   * must return negative if x < y, zero if x == y, or positive if
+   * x > y.
+   */
+  static void sortLeaf(T *pArr, unsigned n,
+                       int (*compare)(const T &x, const T &y));
+};
+
+template <class T> unsigned SearchNSort<T>::smallSortCutoff = 16u;
+
+/*
+ * Natural-order shortcuts, only available for arithmetic types so that
+ * ascending() is never instantiated for types without a < operator.
+ */
+template <class T, bool = std::is_arithmetic<T>::value> struct NaturalOrder {
+  static bool is(int (*)(const T &x, const T &y)) { return false; }
+  static void sortNetwork(T *, unsigned) {}
+};
+
+template <class T> struct NaturalOrder<T, true> {
+  static bool is(int (*compare)(const T &x, const T &y)) {
+    return compare == &SearchNSort<T>::ascending;
+  }
+  static void sortNetwork(T *pArr, unsigned n) {
+    ::sortNetwork(pArr, n, MinMaxExchange());
+  }
 };
 
 /*
@@ -220,6 +410,31 @@ void SearchNSort<T>::insertionSort(T *pArr, unsigned n,
   }
 }
 
+/*
+ * Implementation of private isNatural() helper function.
+ */
+template <class T>
+bool SearchNSort<T>::isNatural(int (*comp)(const T &x, const T &y)) {
+  return NaturalOrder<T>::is(comp);
+}
+
+/*
+ * Implementation of private isOrdered() helper function.
+ */
+template <class T>
+bool SearchNSort<T>::isOrdered(const T *pArr, unsigned n,
+                               int (*comp)(const T &x, const T &y),
+                               bool descending) {
+
+  for (unsigned i = 1u; i < n; i++) {
+    int res = comp(pArr[i - 1], pArr[i]);
+    if (descending ? res < 0 : res > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /*
  * Implementation of linearSearch() function.
  */
@@ -244,6 +459,13 @@ template <class T>
 void SearchNSort<T>::merge(T *pA, T *pB, int left, int right, int mid,
                            int (*comp)(const T &x, const T &y)) {
 
+  // arithmetic types in natural order can use a vectorized merge
+  if (isNatural(comp) &&
+      SimdMerge<T>::merge(pA + left, mid - left, pA + mid, right - mid,
+                          pB + left)) {
+    return;
+  }
+
   int i = left, j = mid;
 
   for (int k = left; k < right; k++) {
@@ -283,6 +505,13 @@ void SearchNSort<T>::mergeSort(T *pA, T *pB, int left, int right,
     return;
   }
 
+  // small ranges go to a sorting network, but only when that can't
+  // change the order of equal elements
+  if ((right - left) <= (int)leafSize() && isNatural(comp)) {
+    sortLeaf(pA + left, right - left, comp);
+    return;
+  }
+
   // otherwise, split, sort, and merge
   int mid = (left + right) / 2;
   mergeSort(pA, pB, left, mid, comp);
@@ -302,8 +531,25 @@ template <class T>
 int SearchNSort<T>::partition(T *pArr, int lo, int hi,
                               int (*compare)(const T &x, const T &y)) {
 
-  // arbitrarily choose first value in range as pivot value
-  const T &pivot = pArr[lo];
+  // median of the values a quarter, half, and three quarters of the way
+  // along becomes the pivot. Unlike the first, middle, and last values,
+  // these aren't all poor picks on presorted or organ-pipe input. Tiny
+  // ranges just use the first value
+  if (hi - lo >= 16) {
+    int a = lo + (hi - lo) / 4, m = lo + (hi - lo) / 2;
+    int b = hi - (hi - lo) / 4;
+    if (compare(pArr[m], pArr[a]) < 0) {
+      std::swap(a, m);
+    }
+    if (compare(pArr[b], pArr[m]) < 0) {
+      m = compare(pArr[b], pArr[a]) < 0 ? a : b;
+    }
+    std::swap(pArr[lo], pArr[m]);
+  }
+
+  // copied, since the first swap below moves pArr[lo] and would leave a
+  // reference looking at a worse pivot
+  const T pivot = pArr[lo];
 
   // indices to slide right and left
   int i = lo - 1;
@@ -334,7 +580,21 @@ int SearchNSort<T>::partition(T *pArr, int lo, int hi,
  */
 template <class T>
 void SearchNSort<T>::quickSort(T *pArr, int lo, int hi,
-                               int (*compare)(const T &x, const T &y)) {
+                               int (*compare)(const T &x, const T &y),
+                               unsigned depth) {
+
+  // small portions are finished by a sorting network
+  if (hi - lo < (int)leafSize()) {
+    sortLeaf(pArr + lo, hi - lo + 1, compare);
+    return;
+  }
+
+  // pivots this bad mean the input defeats quicksort; mergeSort() can't
+  // go quadratic
+  if (depth == 0u) {
+    mergeSort(pArr + lo, hi - lo + 1, compare);
+    return;
+  }
 
   // portion of size 0 or 1 is already sorted!
   if (lo < hi) {
@@ -344,9 +604,57 @@ void SearchNSort<T>::quickSort(T *pArr, int lo, int hi,
     int p = partition(pArr, lo, hi, compare);
 
     // recursively sort left and right halves
-    quickSort(pArr, lo, p, compare);
-    quickSort(pArr, p + 1, hi, compare);
+    quickSort(pArr, lo, p, compare, depth - 1u);
+    quickSort(pArr, p + 1, hi, compare, depth - 1u);
+  }
+}
+
+/*
+ * Implementation of private sampleDescents() helper function.
+ */
+template <class T>
+double SearchNSort<T>::sampleDescents(const T *pArr, unsigned n,
+                                      int (*comp)(const T &x, const T &y)) {
+
+  const unsigned samples = n - 1u < 64u ? n - 1u : 64u;
+
+  unsigned descents = 0u;
+  for (unsigned k = 0u; k < samples; k++) {
+    unsigned i = (unsigned)((unsigned long long)k * (n - 1u) / samples);
+    if (comp(pArr[i], pArr[i + 1]) > 0) {
+      descents++;
+    }
+  }
+  return (double)descents / samples;
+}
+
+/*
+ * Implementation of private sampleDuplicates() helper function.
+ */
+template <class T>
+double SearchNSort<T>::sampleDuplicates(const T *pArr, unsigned n,
+                                        int (*comp)(const T &x, const T &y)) {
+
+  // keep the sample small next to the array it describes
+  const unsigned samples = n / 16u < 64u ? n / 16u : 64u;
+  if (samples < 2u) {
+    return 0.0;
   }
+
+  std::vector<T> sample;
+  sample.reserve(samples);
+  for (unsigned k = 0u; k < samples; k++) {
+    sample.push_back(pArr[(unsigned long long)k * n / samples]);
+  }
+  mergeSort(sample.data(), samples, comp);
+
+  unsigned equal = 0u;
+  for (unsigned i = 1u; i < samples; i++) {
+    if (comp(sample[i - 1], sample[i]) == 0) {
+      equal++;
+    }
+  }
+  return (double)equal / (samples - 1u);
 }
 
 /*
@@ -371,3 +679,82 @@ void SearchNSort<T>::selectionSort(T *pArr, unsigned n,
     }
   }
 }
+
+/*
+ * Implementation of sort() function.
+ */
+template <class T>
+void SearchNSort<T>::sort(T *pArr, unsigned n,
+                          int (*comp)(const T &x, const T &y)) {
+
+  const SortProfile &profile = SortProfile::active();
+
+  if (n <= profile.leafMax && n <= maxNetworkSize) {
+    sortLeaf(pArr, n, comp);
+    return;
+  }
+
+  // sorted or reversed input needs at most one more pass
+  double descents = sampleDescents(pArr, n, comp);
+  if (descents == 0.0 && isOrdered(pArr, n, comp, false)) {
+    return;
+  }
+  if (descents == 1.0 && isOrdered(pArr, n, comp, true)) {
+    std::reverse(pArr, pArr + n);
+    return;
+  }
+
+  // integers from a narrow range are counted rather than compared
+  if (isNatural(comp) && IntegerKeys<T>::trySort(pArr, n)) {
+    return;
+  }
+
+  // presorted input in either direction is nearly done already, and
+  // merging runs is cheaper than partitioning them
+  if (descents <= profile.presortedFraction) {
+    if (n <= profile.insertionMax) {
+      insertionSort(pArr, n, comp);
+    } else {
+      mergeSort(pArr, n, comp);
+    }
+    return;
+  }
+  if (descents >= 1.0 - profile.presortedFraction) {
+    mergeSort(pArr, n, comp);
+    return;
+  }
+
+  unsigned quickMin =
+      isNatural(comp) ? profile.quickMinNatural : profile.quickMinCompare;
+  unsigned quickMinDup = isNatural(comp) ? profile.quickMinNaturalDup
+                                         : profile.quickMinCompareDup;
+
+  // many equal keys shift the point where quickSort() starts to win; the
+  // sample only matters when n falls between the two thresholds
+  if ((n >= quickMin) != (n >= quickMinDup) &&
+      sampleDuplicates(pArr, n, comp) >= profile.duplicateFraction) {
+    quickMin = quickMinDup;
+  }
+  if (n >= quickMin) {
+    quickSort(pArr, n, comp);
+  } else {
+    mergeSort(pArr, n, comp);
+  }
+}
+
+/*
+ * Implementation of private sortLeaf() helper function.
+ */
+template <class T>
+void SearchNSort<T>::sortLeaf(T *pArr, unsigned n,
+                              int (*comp)(const T &x, const T &y)) {
+
+  if (isNatural(comp)) {
+    NaturalOrder<T>::sortNetwork(pArr, n);
+  } else if (std::is_arithmetic<T>::value) {
+    CompareExchange<T> cx = {comp};
+    sortNetwork(pArr, n, cx);
+  } else {
+    insertionSort(pArr, n, comp);
+  }
+}
@@ -0,0 +1,468 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Vectorized merge of two sorted arrays for 32- and 64-bit signed
+ * integers, float, and double, in ascending order.
+ *
+ * Each step loads one block from an input into a register, merges it with
+ * a register of leftovers using an in-register bitonic merge network, and
+ * stores the lower half. The next block always comes from the input whose
+ * next element is smaller, which keeps the output in order. Blocks are 8
+ * or 4 elements with AVX2, and 16 or 8 with AVX-512. What remains when an
+ * input runs out of whole blocks is merged with scalar code.
+ *
+ * The instruction set is picked at run time, the first time each element
+ * type is merged. Builds for other compilers or CPUs get no kernels, and
+ * SimdMerge<T>::merge() always returns false.
+ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SIMD_MERGE_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Scalar merge of three sorted runs, used to finish a vectorized merge.
+ */
+template <class E>
+void mergeTails(const E *pA, unsigned nA, const E *pB, unsigned nB,
+                const E *pC, unsigned nC, E *pOut) {
+  unsigned i = 0u, j = 0u, k = 0u;
+
+  while (i < nA || j < nB || k < nC) {
+    // pick the smallest head among the runs that aren't empty
+    const E *pMin = 0;
+    unsigned *pIdx = 0;
+    if (i < nA) {
+      pMin = pA + i;
+      pIdx = &i;
+    }
+    if (j < nB && (!pMin || pB[j] < *pMin)) {
+      pMin = pB + j;
+      pIdx = &j;
+    }
+    if (k < nC && (!pMin || pC[k] < *pMin)) {
+      pMin = pC + k;
+      pIdx = &k;
+    }
+    *pOut++ = *pMin;
+    (*pIdx)++;
+  }
+}
+
+#ifdef SIMD_MERGE_X86
+
+/*
+ * Main loop of the vectorized merge. K supplies the element type E, the
+ * block width, and load(), store(), and merge() operations; merge(a, b)
+ * leaves the smaller half of a and b in a and the larger in b, both
+ * sorted. The loop is stamped out once per instruction set, because it has
+ * to be compiled for the same target as the kernels it inlines.
+ */
+#define SIMD_MERGE_LOOP(NAME)                                                  \
+  template <class K>                                                           \
+  void NAME(const typename K::E *pA, unsigned nA, const typename K::E *pB,     \
+            unsigned nB, typename K::E *pOut) {                                \
+    typedef typename K::E E;                                                   \
+    const unsigned W = K::width;                                               \
+                                                                               \
+    if (nA < W || nB < W) {                                                    \
+      mergeTails<E>(pA, nA, pB, nB, pB, 0u, pOut);                             \
+      return;                                                                  \
+    }                                                                          \
+                                                                               \
+    typename K::V a = K::load(pA), b = K::load(pB);                            \
+    unsigned i = W, j = W;                                                     \
+    while (true) {                                                             \
+      K::merge(a, b);                                                          \
+      K::store(pOut, a);                                                       \
+      pOut += W;                                                               \
+                                                                               \
+      /* next block comes from the input with the smaller head */              \
+      if (j >= nB || (i < nA && !(pB[j] < pA[i]))) {                           \
+        if (i + W > nA) {                                                      \
+          break;                                                               \
+        }                                                                      \
+        a = K::load(pA + i);                                                   \
+        i += W;                                                                \
+      } else {                                                                 \
+        if (j + W > nB) {                                                      \
+          break;                                                               \
+        }                                                                      \
+        a = K::load(pB + j);                                                   \
+        j += W;                                                                \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    /* leftovers in b are no smaller than anything written so far */           \
+    E buf[K::width];                                                           \
+    K::store(buf, b);                                                          \
+    mergeTails<E>(buf, W, pA + i, nA - i, pB + j, nB - j, pOut);               \
+  }
+
+/*
+ * In the kernels, the smaller of x and y is min(x, y) and the larger is
+ * max(y, x). With floating point min/max instructions that pairing
+ * returns x and y in some order even when one is NaN, so no element is
+ * ever lost or duplicated.
+ */
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+SIMD_MERGE_LOOP(simdMergeAvx2)
+
+struct Avx2Int32 {
+  typedef int32_t E;
+  typedef __m256i V;
+  static const unsigned width = 8u;
+
+  static V load(const E *p) { return _mm256_loadu_si256((const V *)p); }
+  static void store(E *p, V v) { _mm256_storeu_si256((V *)p, v); }
+
+  static V sort(V v) {
+    V p = _mm256_permute2x128_si256(v, v, 0x01);
+    v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p),
+                           0xF0);
+    p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p),
+                           0xCC);
+    p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p),
+                              0xAA);
+  }
+
+  static void merge(V &a, V &b) {
+    b = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1,
+                                                         0));
+    V lo = _mm256_min_epi32(a, b), hi = _mm256_max_epi32(b, a);
+    a = sort(lo);
+    b = sort(hi);
+  }
+};
+
+struct Avx2Float {
+  typedef float E;
+  typedef __m256 V;
+  static const unsigned width = 8u;
+
+  static V load(const E *p) { return _mm256_loadu_ps(p); }
+  static void store(E *p, V v) { _mm256_storeu_ps(p, v); }
+
+  static V sort(V v) {
+    V p = _mm256_permute2f128_ps(v, v, 0x01);
+    v = _mm256_blend_ps(_mm256_min_ps(v, p), _mm256_max_ps(v, p), 0xF0);
+    p = _mm256_permute_ps(v, _MM_SHUFFLE(1, 0, 3, 2));
+    v = _mm256_blend_ps(_mm256_min_ps(v, p), _mm256_max_ps(v, p), 0xCC);
+    p = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_blend_ps(_mm256_min_ps(v, p), _mm256_max_ps(v, p), 0xAA);
+  }
+
+  static void merge(V &a, V &b) {
+    b = _mm256_permutevar8x32_ps(b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    V lo = _mm256_min_ps(a, b), hi = _mm256_max_ps(b, a);
+    a = sort(lo);
+    b = sort(hi);
+  }
+};
+
+struct Avx2Int64 {
+  typedef int64_t E;
+  typedef __m256i V;
+  static const unsigned width = 4u;
+
+  static V load(const E *p) { return _mm256_loadu_si256((const V *)p); }
+  static void store(E *p, V v) { _mm256_storeu_si256((V *)p, v); }
+
+  // AVX2 has no 64-bit min/max, so build them from a compare
+  static V min(V x, V y) {
+    return _mm256_blendv_epi8(x, y, _mm256_cmpgt_epi64(x, y));
+  }
+  static V max(V x, V y) {
+    return _mm256_blendv_epi8(y, x, _mm256_cmpgt_epi64(x, y));
+  }
+
+  static V sort(V v) {
+    V p = _mm256_permute2x128_si256(v, v, 0x01);
+    v = _mm256_blend_epi32(min(v, p), max(v, p), 0xF0);
+    p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm256_blend_epi32(min(v, p), max(v, p), 0xCC);
+  }
+
+  static void merge(V &a, V &b) {
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 1, 2, 3));
+    V lo = min(a, b), hi = max(b, a);
+    a = sort(lo);
+    b = sort(hi);
+  }
+};
+
+struct Avx2Double {
+  typedef double E;
+  typedef __m256d V;
+  static const unsigned width = 4u;
+
+  static V load(const E *p) { return _mm256_loadu_pd(p); }
+  static void store(E *p, V v) { _mm256_storeu_pd(p, v); }
+
+  static V sort(V v) {
+    V p = _mm256_permute2f128_pd(v, v, 0x01);
+    v = _mm256_blend_pd(_mm256_min_pd(v, p), _mm256_max_pd(v, p), 0xC);
+    p = _mm256_permute_pd(v, 0x5);
+    return _mm256_blend_pd(_mm256_min_pd(v, p), _mm256_max_pd(v, p), 0xA);
+  }
+
+  static void merge(V &a, V &b) {
+    b = _mm256_permute4x64_pd(b, _MM_SHUFFLE(0, 1, 2, 3));
+    V lo = _mm256_min_pd(a, b), hi = _mm256_max_pd(b, a);
+    a = sort(lo);
+    b = sort(hi);
+  }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// GCC 12 warns about the _mm512_undefined_*() inside its own intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+SIMD_MERGE_LOOP(simdMergeAvx512)
+
+struct Avx512Int32 {
+  typedef int32_t E;
+  typedef __m512i V;
+  static const unsigned width = 16u;
+
+  static V load(const E *p) { return _mm512_loadu_si512(p); }
+  static void store(E *p, V v) { _mm512_storeu_si512(p, v); }
+
+  static V stage(V v, V p, __mmask16 upper) {
+    return _mm512_mask_blend_epi32(upper, _mm512_min_epi32(v, p),
+                                   _mm512_max_epi32(v, p));
+  }
+
+  static V sort(V v) {
+    v = stage(v, _mm512_shuffle_i32x4(v, v, _MM_SHUFFLE(1, 0, 3, 2)), 0xFF00);
+    v = stage(v, _mm512_shuffle_i32x4(v, v, _MM_SHUFFLE(2, 3, 0, 1)), 0xF0F0);
+    v = stage(
+        v, _mm512_shuffle_epi32(v, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2)),
+        0xCCCC);
+    return stage(
+        v, _mm512_shuffle_epi32(v, (_MM_PERM_ENUM)_MM_SHUFFLE(2, 3, 0, 1)),
+        0xAAAA);
+  }
+
+  static void merge(V &a, V &b) {
+    b = _mm512_permutexvar_epi32(
+        _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+        b);
+    V lo = _mm512_min_epi32(a, b), hi = _mm512_max_epi32(b, a);
+    a = sort(lo);
+    b = sort(hi);
+  }
+};
+
+struct Avx512Float {
+  typedef float E;
+  typedef __m512 V;
+  static const unsigned width = 16u;
+
+  static V load(const E *p) { return _mm512_loadu_ps(p); }
+  static void store(E *p, V v) { _mm512_storeu_ps(p, v); }
+
+  static V stage(V v, V p, __mmask16 upper) {
+    return _mm512_mask_blend_ps(upper, _mm512_min_ps(v, p),
+                                _mm512_max_ps(v, p));
+  }
+
+  static V sort(V v) {
+    v = stage(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(1, 0, 3, 2)), 0xFF00);
+    v = stage(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(2, 3, 0, 1)), 0xF0F0);
+    v = stage(v, _mm512_permute_ps(v, _MM_SHUFFLE(1, 0, 3, 2)), 0xCCCC);
+    return stage(v, _mm512_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xAAAA);
+  }
+
+  static void merge(V &a, V &b) {
+    b = _mm512_permutexvar_ps(
+        _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+        b);
+    V lo = _mm512_min_ps(a, b), hi = _mm512_max_ps(b, a);
+    a = sort(lo);
+    b = sort(hi);
+  }
+};
+
+struct Avx512Int64 {
+  typedef int64_t E;
+  typedef __m512i V;
+  static const unsigned width = 8u;
+
+  static V load(const E *p) { return _mm512_loadu_si512(p); }
+  static void store(E *p, V v) { _mm512_storeu_si512(p, v); }
+
+  static V stage(V v, V p, __mmask8 upper) {
+    return _mm512_mask_blend_epi64(upper, _mm512_min_epi64(v, p),
+                                   _mm512_max_epi64(v, p));
+  }
+
+  static V sort(V v) {
+    v = stage(v, _mm512_shuffle_i64x2(v, v, _MM_SHUFFLE(1, 0, 3, 2)), 0xF0);
+    v = stage(v, _mm512_shuffle_i64x2(v, v, _MM_SHUFFLE(2, 3, 0, 1)), 0xCC);
+    return stage(
+        v, _mm512_shuffle_epi32(v, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2)),
+        0xAA);
+  }
+
+  static void merge(V &a, V &b) {
+    b = _mm512_permutexvar_epi64(_mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0), b);
+    V lo = _mm512_min_epi64(a, b), hi = _mm512_max_epi64(b, a);
+    a = sort(lo);
+    b = sort(hi);
+  }
+};
+
+struct Avx512Double {
+  typedef double E;
+  typedef __m512d V;
+  static const unsigned width = 8u;
+
+  static V load(const E *p) { return _mm512_loadu_pd(p); }
+  static void store(E *p, V v) { _mm512_storeu_pd(p, v); }
+
+  static V stage(V v, V p, __mmask8 upper) {
+    return _mm512_mask_blend_pd(upper, _mm512_min_pd(v, p),
+                                _mm512_max_pd(v, p));
+  }
+
+  static V sort(V v) {
+    v = stage(v, _mm512_shuffle_f64x2(v, v, _MM_SHUFFLE(1, 0, 3, 2)), 0xF0);
+    v = stage(v, _mm512_shuffle_f64x2(v, v, _MM_SHUFFLE(2, 3, 0, 1)), 0xCC);
+    return stage(v, _mm512_permute_pd(v, 0x55), 0xAA);
+  }
+
+  static void merge(V &a, V &b) {
+    b = _mm512_permutexvar_pd(_mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0), b);
+    V lo = _mm512_min_pd(a, b), hi = _mm512_max_pd(b, a);
+    a = sort(lo);
+    b = sort(hi);
+  }
+};
+
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+#undef SIMD_MERGE_LOOP
+
+/*
+ * Kernels for one element type, indexed by instruction set.
+ */
+template <class E> struct SimdMergeKernels;
+
+template <> struct SimdMergeKernels<int32_t> {
+  typedef Avx2Int32 Avx2;
+  typedef Avx512Int32 Avx512;
+};
+
+template <> struct SimdMergeKernels<int64_t> {
+  typedef Avx2Int64 Avx2;
+  typedef Avx512Int64 Avx512;
+};
+
+template <> struct SimdMergeKernels<float> {
+  typedef Avx2Float Avx2;
+  typedef Avx512Float Avx512;
+};
+
+template <> struct SimdMergeKernels<double> {
+  typedef Avx2Double Avx2;
+  typedef Avx512Double Avx512;
+};
+
+/*
+ * Best merge for element type E on this CPU, or null if there is none.
+ */
+template <class E>
+void (*selectSimdMerge())(const E *, unsigned, const E *, unsigned, E *) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return &simdMergeAvx512<typename SimdMergeKernels<E>::Avx512>;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return &simdMergeAvx2<typename SimdMergeKernels<E>::Avx2>;
+  }
+  return 0;
+}
+
+#endif
+
+/*
+ * Kernel element type for T, or void if there is no kernel for T.
+ */
+template <class T> struct SimdElement { typedef void type; };
+
+template <> struct SimdElement<int32_t> { typedef int32_t type; };
+
+template <> struct SimdElement<int64_t> { typedef int64_t type; };
+
+template <> struct SimdElement<float> { typedef float type; };
+
+template <> struct SimdElement<double> { typedef double type; };
+
+/**
+ * Vectorized merge for element type T.
+ */
+template <class T, class E = typename SimdElement<T>::type> struct SimdMerge {
+  /**
+   * Merge two sorted arrays into a third, in ascending order by the <
+   * operator. Equal elements may come out in either order.
+   *
+   * \param pA Pointer to the first element of one sorted array.
+   * \param nA Number of elements in pA.
+   * \param pB Pointer to the first element of the other sorted array.
+   * \param nB Number of elements in pB.
+   * \param pOut Destination for all nA + nB elements; must not overlap
+   * either input.
+   * \return true if the arrays were merged, false if there is no
+   * vectorized merge for T on this machine and nothing was done.
+   */
+  static bool merge(const T *pA, unsigned nA, const T *pB, unsigned nB,
+                    T *pOut) {
+#ifdef SIMD_MERGE_X86
+    static void (*const pMerge)(const E *, unsigned, const E *, unsigned,
+                                E *) = selectSimdMerge<E>();
+    if (pMerge) {
+      pMerge(pA, nA, pB, nB, pOut);
+      return true;
+    }
+#endif
+    return false;
+  }
+};
+
+template <class T> struct SimdMerge<T, void> {
+  static bool merge(const T *, unsigned, const T *, unsigned, T *) {
+    return false;
+  }
+};
+
+/**
+ * Get the instruction set the vectorized merges use on this machine.
+ *
+ * \return "avx512f", "avx2", or "none".
+ */
+inline const char *simdMergeTarget() {
+#ifdef SIMD_MERGE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return "avx512f";
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return "avx2";
+  }
+#endif
+  return "none";
+}
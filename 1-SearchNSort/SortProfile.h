@@ -0,0 +1,198 @@
+#pragma once
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Thresholds SearchNSort<T>::sort() uses to pick an algorithm.
+ *
+ * The compiled-in defaults come from a typical x86-64 desktop. Running the
+ * calibrate program measures the crossover points on the local machine
+ * and saves them to a profile file, which is loaded the first time sort()
+ * is called.
+ *
+ * A profile file holds one "key value" pair per line; lines starting with
+ * '#' and unknown keys are ignored.
+ */
+struct SortProfile {
+  /**
+   * Arrays of at most this many elements (and at most maxNetworkSize) are
+   * sorted with a sorting network.
+   */
+  unsigned leafMax;
+
+  /**
+   * Presorted arrays of at most this many elements are sorted with
+   * insertionSort(); larger ones use mergeSort().
+   */
+  unsigned insertionMax;
+
+  /**
+   * Arrays where at most this fraction of sampled neighbours are out of
+   * order (or in order) count as presorted (or reverse presorted).
+   */
+  double presortedFraction;
+
+  /**
+   * Smallest array size where quickSort() beats mergeSort() with a
+   * caller-supplied comparison function. UINT_MAX means never.
+   */
+  unsigned quickMinCompare;
+
+  /**
+   * Smallest array size where quickSort() beats mergeSort() for
+   * arithmetic types sorted with ascending(). UINT_MAX means never.
+   */
+  unsigned quickMinNatural;
+
+  /**
+   * Arrays where at least this fraction of sampled elements equal their
+   * sorted neighbour in the sample count as duplicate heavy.
+   */
+  double duplicateFraction;
+
+  /**
+   * quickMinCompare for duplicate-heavy arrays. The compiled-in
+   * duplicate thresholds equal the plain ones, as measured on the default
+   * machine, so sort() only samples for duplicates when a calibrated
+   * profile splits them.
+   */
+  unsigned quickMinCompareDup;
+
+  /**
+   * quickMinNatural for duplicate-heavy arrays.
+   */
+  unsigned quickMinNaturalDup;
+
+  /**
+   * Integer keys sorted with ascending() are counting sorted when their
+   * range is at most this many times the number of keys (plus 256).
+   */
+  double countingRangeFactor;
+
+  /**
+   * Create a profile with the compiled-in defaults.
+   */
+  SortProfile()
+      : leafMax(8u), insertionMax(64u), presortedFraction(0.02),
+        quickMinCompare(0u), quickMinNatural(UINT_MAX),
+        duplicateFraction(0.5), quickMinCompareDup(0u),
+        quickMinNaturalDup(UINT_MAX), countingRangeFactor(1.0) {}
+
+  /**
+   * Get the profile sort() uses. The first call loads it from
+   * defaultPath(); if that fails, the compiled-in defaults are used.
+   * Changes to the returned profile affect later sort() calls.
+   *
+   * \return Reference to the active profile.
+   */
+  static SortProfile &active() {
+    static SortProfile profile = loadDefault();
+    return profile;
+  }
+
+  /**
+   * Get the path of the profile file loaded at startup.
+   *
+   * \return The SNS_PROFILE environment variable if it is set, or
+   * "sns.profile" in the current directory otherwise.
+   */
+  static const char *defaultPath() {
+    const char *pszPath = getenv("SNS_PROFILE");
+    return pszPath ? pszPath : "sns.profile";
+  }
+
+  /**
+   * Read thresholds from a profile file. Keys missing from the file keep
+   * their current values.
+   *
+   * \param pszPath Path of the file to read.
+   * \return true if the file was read, false if it couldn't be opened.
+   */
+  bool load(const char *pszPath) {
+    FILE *pFile = fopen(pszPath, "r");
+    if (!pFile) {
+      return false;
+    }
+
+    char szLine[256], szKey[64];
+    double value;
+    while (fgets(szLine, sizeof(szLine), pFile)) {
+      if (szLine[0] == '#' ||
+          sscanf(szLine, "%63s %lf", szKey, &value) != 2) {
+        continue;
+      }
+
+      if (strcmp(szKey, "leafMax") == 0) {
+        leafMax = toUnsigned(value);
+      } else if (strcmp(szKey, "insertionMax") == 0) {
+        insertionMax = toUnsigned(value);
+      } else if (strcmp(szKey, "presortedFraction") == 0) {
+        presortedFraction = value;
+      } else if (strcmp(szKey, "quickMinCompare") == 0) {
+        quickMinCompare = toUnsigned(value);
+      } else if (strcmp(szKey, "quickMinNatural") == 0) {
+        quickMinNatural = toUnsigned(value);
+      } else if (strcmp(szKey, "duplicateFraction") == 0) {
+        duplicateFraction = value;
+      } else if (strcmp(szKey, "quickMinCompareDup") == 0) {
+        quickMinCompareDup = toUnsigned(value);
+      } else if (strcmp(szKey, "quickMinNaturalDup") == 0) {
+        quickMinNaturalDup = toUnsigned(value);
+      } else if (strcmp(szKey, "countingRangeFactor") == 0) {
+        countingRangeFactor = value;
+      }
+    }
+
+    fclose(pFile);
+    return true;
+  }
+
+  /**
+   * Write the thresholds to a profile file.
+   *
+   * \param pszPath Path of the file to write.
+   * \return true if the file was written, false otherwise.
+   */
+  bool save(const char *pszPath) const {
+    FILE *pFile = fopen(pszPath, "w");
+    if (!pFile) {
+      return false;
+    }
+
+    fprintf(pFile, "# SearchNSort<T>::sort() thresholds, from calibrate\n");
+    fprintf(pFile, "leafMax %u\n", leafMax);
+    fprintf(pFile, "insertionMax %u\n", insertionMax);
+    fprintf(pFile, "presortedFraction %g\n", presortedFraction);
+    fprintf(pFile, "quickMinCompare %u\n", quickMinCompare);
+    fprintf(pFile, "quickMinNatural %u\n", quickMinNatural);
+    fprintf(pFile, "duplicateFraction %g\n", duplicateFraction);
+    fprintf(pFile, "quickMinCompareDup %u\n", quickMinCompareDup);
+    fprintf(pFile, "quickMinNaturalDup %u\n", quickMinNaturalDup);
+    fprintf(pFile, "countingRangeFactor %g\n", countingRangeFactor);
+
+    return fclose(pFile) == 0;
+  }
+
+private:
+  /*
+   * Profile loaded from defaultPath(), or the defaults.
+   */
+  static SortProfile loadDefault() {
+    SortProfile profile;
+    profile.load(defaultPath());
+    return profile;
+  }
+
+  /*
+   * Clamp a value read from a file to the range of unsigned.
+   */
+  static unsigned toUnsigned(double value) {
+    if (value <= 0.0) {
+      return 0u;
+    }
+    return value >= (double)UINT_MAX ? UINT_MAX : (unsigned)value;
+  }
+};
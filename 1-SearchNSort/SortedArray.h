@@ -0,0 +1,356 @@
+#pragma once
+
+#include "SearchNSort.h"
+#include <vector>
+
+/**
+ * Sorted array of unique keys with batched updates.
+ *
+ * Inserts and removals are not applied to the sorted array right away.
+ * Instead they are recorded in a small update log, kept sorted by binary
+ * insertion. Once the log holds logCapacity entries, it is merged into the
+ * main array in a single linear pass. Lookups binary search the log first
+ * and then the main array, so they always reflect every update.
+ *
+ * The log never holds two entries for the same key. An insert entry means
+ * the key is not in the main array yet; a removal entry means it is.
+ */
+template <class T> class SortedArray {
+public:
+  /**
+   * Create an empty sorted array.
+   *
+   * \param compare Pointer to function used to compare two elements;
+   * must return negative if x < y, zero if x == y, or positive if
+   * x > y.
+   * \param logCapacity Number of pending updates that triggers a merge
+   * into the main array.
+   */
+  SortedArray(int (*compare)(const T &x, const T &y),
+              unsigned logCapacity = 64u);
+
+  /**
+   * Replace the contents with the keys from an array. Duplicate keys are
+   * kept once. Nothing is logged, and merge statistics are unchanged.
+   *
+   * \param pArr Pointer to the first element of the array to load.
+   * \param n Number of elements in the array.
+   */
+  void assign(const T *pArr, unsigned n);
+
+  /**
+   * Determine if a key is in the array.
+   *
+   * \param key Key value to search for.
+   * \return true if key is in the array, false otherwise.
+   */
+  bool contains(const T &key) const;
+
+  /**
+   * Get the sorted keys. Any pending updates are merged first.
+   *
+   * \return Pointer to the first of size() keys, in ascending order.
+   */
+  const T *data();
+
+  /**
+   * Merge all pending updates into the main array.
+   */
+  void flush();
+
+  /**
+   * Add a key to the array.
+   *
+   * \param key Key value to add.
+   * \return true if the key was added, false if it was already present.
+   */
+  bool insert(const T &key);
+
+  /**
+   * Get the number of merges performed so far.
+   *
+   * \return Number of times the update log was merged into the main array.
+   */
+  unsigned merges() const { return mergeCount; }
+
+  /**
+   * Get the number of updates waiting in the log.
+   *
+   * \return Number of pending updates.
+   */
+  unsigned pending() const { return updates.size(); }
+
+  /**
+   * Remove a key from the array.
+   *
+   * \param key Key value to remove.
+   * \return true if the key was removed, false if it wasn't present.
+   */
+  bool remove(const T &key);
+
+  /**
+   * Get the number of keys in the array, including pending updates.
+   *
+   * \return Number of keys.
+   */
+  unsigned size() const { return count; }
+
+  /**
+   * Get the write amplification of the merges performed so far.
+   *
+   * \return Number of elements written to the main array during merges,
+   * divided by the number of updates those merges applied; 0 if there
+   * have been no merges.
+   */
+  double writeAmplification() const;
+
+private:
+  /**
+   * Pending update to the main array.
+   */
+  struct Update {
+    T key;
+    bool erase;
+  };
+
+  /**
+   * Find the log entry for a key.
+   *
+   * \param key Key value to search for.
+   * \return Index of the entry in the log, or -1 if there is none.
+   */
+  int findUpdate(const T &key) const;
+
+  /**
+   * Find where a key belongs in the log.
+   *
+   * \param key Key value to search for.
+   * \return Index of the first entry whose key is not less than key.
+   */
+  unsigned lowerUpdate(const T &key) const;
+
+  /**
+   * Record an update, merging the log if it is full.
+   *
+   * \param key Key value to update.
+   * \param erase true for a removal, false for an insert.
+   */
+  void logUpdate(const T &key, bool erase);
+
+  int (*compare)(const T &x, const T &y);
+  unsigned logCapacity;
+  unsigned count;
+  std::vector<T> items;
+  std::vector<Update> updates;
+  unsigned mergeCount;
+  unsigned long long written;
+  unsigned long long applied;
+};
+
+/*
+ * Implementation of SortedArray constructor.
+ */
+template <class T>
+SortedArray<T>::SortedArray(int (*comp)(const T &x, const T &y),
+                            unsigned logCap)
+    : compare(comp), logCapacity(logCap > 0u ? logCap : 1u), count(0u),
+      mergeCount(0u), written(0ull), applied(0ull) {
+
+  updates.reserve(logCapacity);
+}
+
+/*
+ * Implementation of contains() function.
+ */
+template <class T> bool SortedArray<T>::contains(const T &key) const {
+
+  // the log holds the most recent word on any key it mentions
+  int i = findUpdate(key);
+  if (i >= 0) {
+    return !updates[i].erase;
+  }
+
+  return SearchNSort<T>::binarySearch(items.data(), items.size(), key,
+                                      compare) >= 0;
+}
+
+/*
+ * Implementation of assign() function.
+ */
+template <class T> void SortedArray<T>::assign(const T *pArr, unsigned n) {
+
+  items.assign(pArr, pArr + n);
+  updates.clear();
+
+  if (n > 0u) {
+    SearchNSort<T>::mergeSort(items.data(), n, compare);
+
+    // squeeze out duplicates
+    unsigned k = 1u;
+    for (unsigned i = 1u; i < n; i++) {
+      if (compare(items[k - 1], items[i]) != 0) {
+        items[k++] = items[i];
+      }
+    }
+    items.resize(k);
+  }
+
+  count = items.size();
+}
+
+/*
+ * Implementation of data() function.
+ */
+template <class T> const T *SortedArray<T>::data() {
+  flush();
+  return items.data();
+}
+
+/*
+ * Implementation of private findUpdate() helper function.
+ */
+template <class T> int SortedArray<T>::findUpdate(const T &key) const {
+
+  unsigned i = lowerUpdate(key);
+  if (i < updates.size() && compare(updates[i].key, key) == 0) {
+    return i;
+  }
+
+  // not found? Return -1 flag value
+  return -1;
+}
+
+/*
+ * Implementation of flush() function.
+ */
+template <class T> void SortedArray<T>::flush() {
+
+  if (updates.empty()) {
+    return;
+  }
+
+  // merge log and main array in one linear pass. Removals always match a
+  // key in the main array, inserts never do
+  std::vector<T> merged;
+  merged.reserve(count);
+  unsigned i = 0u, j = 0u;
+  while (i < items.size() || j < updates.size()) {
+    if (j >= updates.size()) {
+      merged.push_back(items[i++]);
+    } else if (i >= items.size()) {
+      merged.push_back(updates[j++].key);
+    } else {
+      int res = compare(items[i], updates[j].key);
+      if (res < 0) {
+        merged.push_back(items[i++]);
+      } else if (res > 0) {
+        merged.push_back(updates[j++].key);
+      } else {
+        i++;
+        j++;
+      }
+    }
+  }
+
+  items.swap(merged);
+  mergeCount++;
+  written += items.size();
+  applied += updates.size();
+  updates.clear();
+}
+
+/*
+ * Implementation of insert() function.
+ */
+template <class T> bool SortedArray<T>::insert(const T &key) {
+
+  int i = findUpdate(key);
+  if (i >= 0) {
+    if (!updates[i].erase) {
+      return false;
+    }
+
+    // key is still in the main array, so forget its pending removal
+    updates.erase(updates.begin() + i);
+    count++;
+    return true;
+  }
+
+  if (SearchNSort<T>::binarySearch(items.data(), items.size(), key,
+                                   compare) >= 0) {
+    return false;
+  }
+
+  logUpdate(key, false);
+  count++;
+  return true;
+}
+
+/*
+ * Implementation of private lowerUpdate() helper function.
+ */
+template <class T> unsigned SortedArray<T>::lowerUpdate(const T &key) const {
+
+  unsigned lo = 0u, hi = updates.size();
+  while (lo < hi) {
+    unsigned mid = lo + (hi - lo) / 2u;
+    if (compare(updates[mid].key, key) < 0) {
+      lo = mid + 1u;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/*
+ * Implementation of private logUpdate() helper function.
+ */
+template <class T> void SortedArray<T>::logUpdate(const T &key, bool erase) {
+
+  Update u = {key, erase};
+  updates.insert(updates.begin() + lowerUpdate(key), u);
+
+  if (updates.size() >= logCapacity) {
+    flush();
+  }
+}
+
+/*
+ * Implementation of remove() function.
+ */
+template <class T> bool SortedArray<T>::remove(const T &key) {
+
+  int i = findUpdate(key);
+  if (i >= 0) {
+    if (updates[i].erase) {
+      return false;
+    }
+
+    // key never made it to the main array, so just drop its insert
+    updates.erase(updates.begin() + i);
+    count--;
+    return true;
+  }
+
+  if (SearchNSort<T>::binarySearch(items.data(), items.size(), key,
+                                   compare) < 0) {
+    return false;
+  }
+
+  logUpdate(key, true);
+  count--;
+  return true;
+}
+
+/*
+ * Implementation of writeAmplification() function.
+ */
+template <class T> double SortedArray<T>::writeAmplification() const {
+
+  if (applied == 0ull) {
+    return 0.0;
+  }
+
+  return static_cast<double>(written) / applied;
+}
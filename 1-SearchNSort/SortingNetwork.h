@@ -0,0 +1,178 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+/**
+ * Compile-time sorting networks for small, fixed-size arrays.
+ *
+ * The networks follow Batcher's merge-exchange sort (Knuth, TAOCP vol. 3,
+ * Algorithm 5.2.2M), which works for any size and is optimal or within a
+ * few comparators of the best known networks for n <= 32. Every loop of
+ * the algorithm is unrolled by template recursion, so SortingNetwork<N>
+ * compiles to a straight-line sequence of compare-exchange operations with
+ * no data-dependent branches.
+ */
+
+/**
+ * Smallest t such that 2^t >= n.
+ */
+constexpr unsigned networkLog2(unsigned n, unsigned t = 0u) {
+  return (1u << t) >= n ? t : networkLog2(n, t + 1u);
+}
+
+/**
+ * Compare-exchange using the < operator. Written as two selects so
+ * arithmetic types compile to branchless min/max instructions.
+ */
+struct MinMaxExchange {
+  template <class T> void operator()(T &x, T &y) const {
+    T a = x, b = y;
+    x = (b < a) ? b : a;
+    y = (b < a) ? a : b;
+  }
+};
+
+/**
+ * Compare-exchange using a SearchNSort-style comparison function. Only
+ * elements that are out of order are touched, since copying a type like
+ * std::string costs far more than the comparison.
+ */
+template <class T, bool = std::is_arithmetic<T>::value>
+struct CompareExchange {
+  int (*compare)(const T &x, const T &y);
+
+  void operator()(T &x, T &y) const {
+    if (compare(x, y) > 0) {
+      std::swap(x, y);
+    }
+  }
+};
+
+/**
+ * Compare-exchange for arithmetic types, written as two selects so it
+ * compiles without a data-dependent branch.
+ */
+template <class T> struct CompareExchange<T, true> {
+  int (*compare)(const T &x, const T &y);
+
+  void operator()(T &x, T &y) const {
+    bool swap = compare(x, y) > 0;
+    T a = x, b = y;
+    x = swap ? b : a;
+    y = swap ? a : b;
+  }
+};
+
+/*
+ * Innermost loop of Algorithm M: compare-exchange elements I and I + D
+ * for every I < N - D with (I & P) == R.
+ */
+template <unsigned N, unsigned P, unsigned D, unsigned R, unsigned I,
+          bool Done = (I + D >= N)>
+struct NetworkPass {
+  template <class T, class CX> static void apply(T *pArr, const CX &cx) {
+    if ((I & P) == R) {
+      cx(pArr[I], pArr[I + D]);
+    }
+    NetworkPass<N, P, D, R, I + 1u>::apply(pArr, cx);
+  }
+};
+
+template <unsigned N, unsigned P, unsigned D, unsigned R, unsigned I>
+struct NetworkPass<N, P, D, R, I, true> {
+  template <class T, class CX> static void apply(T *, const CX &) {}
+};
+
+/*
+ * Middle loop of Algorithm M: run passes for distances D = P, then
+ * Q - P for halving Q, until the distance reaches zero.
+ */
+template <unsigned N, unsigned P, unsigned Q, unsigned R, unsigned D>
+struct NetworkMerge {
+  template <class T, class CX> static void apply(T *pArr, const CX &cx) {
+    NetworkPass<N, P, D, R, 0u>::apply(pArr, cx);
+    NetworkMerge<N, P, Q / 2u, P, Q - P>::apply(pArr, cx);
+  }
+};
+
+template <unsigned N, unsigned P, unsigned Q, unsigned R>
+struct NetworkMerge<N, P, Q, R, 0u> {
+  template <class T, class CX> static void apply(T *, const CX &) {}
+};
+
+/*
+ * Outer loop of Algorithm M: one merge round for each P = 2^(t - 1),
+ * ..., 2, 1.
+ */
+template <unsigned N, unsigned P> struct NetworkRounds {
+  static const unsigned Top = 1u << (networkLog2(N) - 1u);
+
+  template <class T, class CX> static void apply(T *pArr, const CX &cx) {
+    NetworkMerge<N, P, Top, 0u, P>::apply(pArr, cx);
+    NetworkRounds<N, P / 2u>::apply(pArr, cx);
+  }
+};
+
+template <unsigned N> struct NetworkRounds<N, 0u> {
+  template <class T, class CX> static void apply(T *, const CX &) {}
+};
+
+/**
+ * Sorting network for arrays of exactly N elements.
+ */
+template <unsigned N> struct SortingNetwork {
+  /**
+   * Sort an array of N elements.
+   *
+   * \param pArr Pointer to the first element of the array to sort.
+   * \param cx Compare-exchange operation; after cx(x, y), x must not
+   * belong after y.
+   */
+  template <class T, class CX> static void apply(T *pArr, const CX &cx) {
+    NetworkRounds<N, (N < 2u ? 0u : 1u << (networkLog2(N) - 1u))>::apply(
+        pArr, cx);
+  }
+};
+
+/*
+ * Fill table[0..N] with the sorting networks for those sizes.
+ */
+template <unsigned N> struct NetworkTable {
+  template <class T, class CX>
+  static void fill(void (**ppTable)(T *, const CX &)) {
+    ppTable[N] = &SortingNetwork<N>::template apply<T, CX>;
+    NetworkTable<N - 1u>::fill(ppTable);
+  }
+};
+
+template <> struct NetworkTable<0u> {
+  template <class T, class CX>
+  static void fill(void (**ppTable)(T *, const CX &)) {
+    ppTable[0] = &SortingNetwork<0u>::template apply<T, CX>;
+  }
+};
+
+/**
+ * Largest array size sortNetwork() handles.
+ */
+const unsigned maxNetworkSize = 32u;
+
+/**
+ * Sort a small array with the sorting network for its size.
+ *
+ * \param pArr Pointer to the first element of the array to sort.
+ * \param n Size of the array; must be at most maxNetworkSize.
+ * \param cx Compare-exchange operation; after cx(x, y), x must not
+ * belong after y.
+ */
+template <class T, class CX>
+void sortNetwork(T *pArr, unsigned n, const CX &cx) {
+  struct Table {
+    void (*pFn[maxNetworkSize + 1u])(T *, const CX &);
+    Table() { NetworkTable<maxNetworkSize>::fill(pFn); }
+  };
+  static const Table table;
+
+  table.pFn[n](pArr, cx);
+}
@@ -1,4 +1,10 @@
+#include "CountingSort.h"
+#include "ResumableSort.h"
 #include "SearchNSort.h"
+#include "SortedArray.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <utility>
@@ -63,10 +69,112 @@ int main() {
   SearchNSort<int>::mergeSort(pArr, 200, compare);
   print(pArr, 200);
 
+  shuffle(pArr, 200);
+  SearchNSort<int>::mergeSort(pArr, 200, SearchNSort<int>::ascending);
+  print(pArr, 200);
+
   shuffle(pArr, 200);
   SearchNSort<int>::quickSort(pArr, 200, compare);
   print(pArr, 200);
 
+  shuffle(pArr, 200);
+  SearchNSort<int>::sort(pArr, 200, compare);
+  print(pArr, 200);
+
+  // a profile whose duplicate thresholds differ sends duplicate-heavy
+  // input through sort()'s duplicate sample
+  SortProfile &profile = SortProfile::active();
+  SortProfile saved = profile, split;
+  split.quickMinCompare = UINT_MAX;
+  split.quickMinCompareDup = 0u;
+  if (split.save("split.profile") && profile.load("split.profile")) {
+    int dups[200];
+    for (int i = 0; i < 200; i++) {
+      dups[i] = rand() % 4;
+    }
+    SearchNSort<int>::sort(dups, 200, compare);
+    print(dups, 200);
+  }
+  remove("split.profile");
+  profile = saved;
+
+  shuffle(pArr, 200);
+  CountingSort<int>::sort(pArr, 200);
+  print(pArr, 200);
+
+  unsigned counts[10];
+  CountingSort<int>::histogram(pArr, 200, 0, 9, counts);
+  for (unsigned i = 0u; i < 10u; i++) {
+    cout << counts[i] << " ";
+  }
+  cout << endl;
+
+  int top[] = {INT_MAX, INT_MAX - 1, INT_MAX, INT_MAX - 2};
+  CountingSort<int>::sort(top, 4);
+  print(top, 4);
+
+  // payloads are the starting positions, so equal keys must keep them in
+  // increasing order
+  shuffle(pArr, 200);
+  int positions[200];
+  for (int i = 0; i < 200; i++) {
+    positions[i] = i;
+  }
+  CountingSort<int>::sort(pArr, positions, 200);
+  print(pArr, 200);
+  print(positions, 200);
+
+  // enough keys that four threads really count them
+  const unsigned nBig = 1u << 18;
+  int *pBig = new int[nBig];
+  for (unsigned i = 0u; i < nBig; i++) {
+    pBig[i] = rand() % 10;
+  }
+  unsigned oneThread[10], fourThreads[10];
+  CountingSort<int>::histogram(pBig, nBig, 0, 9, oneThread);
+  CountingSort<int>::histogram(pBig, nBig, 0, 9, fourThreads, 4u);
+  cout << equal(oneThread, oneThread + 10, fourThreads) << endl;
+  delete[] pBig;
+
+  // an empty range is refused before the counters are touched
+  cout << CountingSort<int>::histogram(pArr, 200u, 5, 3, oneThread) << endl;
+
+  shuffle(pArr, 200);
+  ResumableSort<int> rs(pArr, 200, compare);
+  while (!rs.step(100ull)) {
+    cout << rs.finalized() << " ";
+  }
+  cout << endl;
+  print(pArr, 200);
+
+  // 100 elements take an odd number of merge passes and 200 an even
+  // number, so the runs start out in each of the two buffers
+  for (unsigned n = 100u; n <= 200u; n += 100u) {
+    shuffle(pArr, n);
+    ResumableSort<int> rsMerge(pArr, n, compare, ResumableSort<int>::MERGE);
+    while (!rsMerge.step(100ull)) {
+      cout << rsMerge.finalized() << ":" << rsMerge.progress() << " ";
+    }
+    cout << endl;
+    print(pArr, n);
+  }
+
+  shuffle(pArr, 200);
+  SearchNSort<int>::sortSmall<16>(pArr);
+  SearchNSort<int>::sortSmall<16>(pArr + 16, compare);
+  print(pArr, 32);
+
+  SortedArray<int> sa(compare, 16u);
+  sa.assign(pArr, 200);
+  for (int i = 0; i < 40; i++) {
+    sa.insert(rand() % 400);
+    sa.remove(rand() % 400);
+  }
+  cout << sa.size() << " " << sa.pending() << " " << sa.contains(59) << " "
+       << sa.contains(300) << endl;
+  print(sa.data(), sa.size());
+  cout << sa.merges() << " " << sa.writeAmplification() << endl;
+
   delete[] pArr;
 
   return EXIT_SUCCESS;
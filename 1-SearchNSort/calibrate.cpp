@@ -0,0 +1,333 @@
+#include "SearchNSort.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+
+int compare(const int &x, const int &y) { return (x > y) - (x < y); }
+
+typedef void (*SortFn)(int *, unsigned, int (*)(const int &, const int &));
+
+typedef void (*FillFn)(int *, unsigned);
+
+void fill(int *pA, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    pA[i] = rand();
+  }
+}
+
+/*
+ * Random data with keys from only 16 values.
+ */
+void fillDuplicates(int *pA, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    pA[i] = rand() % 16;
+  }
+}
+
+/*
+ * Organ-pipe data, rising to n / 2 and then falling. Neighbouring pairs
+ * look half ascending and half descending, just like random data, so
+ * sort() can't tell the two apart; first-element pivots are all bad.
+ */
+void fillOrganPipe(int *pA, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    pA[i] = i < n / 2u ? i : n - i;
+  }
+}
+
+/*
+ * Sorted data with about 1% of the elements swapped to random places.
+ */
+void fillPresorted(int *pA, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    pA[i] = i;
+  }
+  for (unsigned i = 0u; i < n / 100u + 1u; i++) {
+    std::swap(pA[rand() % n], pA[rand() % n]);
+  }
+}
+
+/*
+ * Counting sort the way sort() runs it.
+ */
+void countingSort(int *pArr, unsigned n, int (*)(const int &, const int &)) {
+  KeyCounts<int>::trySort(pArr, n);
+}
+
+/*
+ * Number of n-element arrays in an input pool for reps repetitions: one
+ * per repetition, up to about 2^20 elements in all. Sorting different
+ * data each time keeps the branch predictor from learning one input.
+ */
+unsigned poolSize(unsigned n, unsigned reps) {
+  unsigned pool = (1u << 20) / n;
+  if (pool < 1u) {
+    return 1u;
+  }
+  return pool < reps ? pool : reps;
+}
+
+/*
+ * Total time in ns to sort reps arrays of n elements, each freshly
+ * filled from the next of the pool arrays in pSrc.
+ */
+long double timeSort(SortFn sort, const int *pSrc, unsigned pool, int *pArr,
+                     unsigned n, unsigned reps,
+                     int (*comp)(const int &, const int &)) {
+  using namespace std;
+
+  long double dur = 0;
+  for (unsigned r = 0u; r < reps; r++) {
+    const int *pIn = pSrc + (unsigned long long)(r % pool) * n;
+    copy(pIn, pIn + n, pArr);
+    auto begin = chrono::high_resolution_clock::now();
+    sort(pArr, n, comp);
+    auto end = chrono::high_resolution_clock::now();
+    dur += chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  }
+  return dur;
+}
+
+/*
+ * Compare sortSmall<N>() against the recursive sorts for random data of
+ * size N, then try the next size down. pSrc holds at least reps * N
+ * elements, so each repetition sorts different data. Returns the largest
+ * N where the network wins.
+ */
+template <unsigned N> struct LeafProbe {
+  static unsigned run(const int *pSrc, int *pArr, unsigned reps) {
+    using namespace std;
+
+    long double net = 0;
+    for (unsigned r = 0u; r < reps; r++) {
+      const int *pIn = pSrc + r * N;
+      copy(pIn, pIn + N, pArr);
+      auto begin = chrono::high_resolution_clock::now();
+      SearchNSort<int>::sortSmall<N>(pArr, compare);
+      auto end = chrono::high_resolution_clock::now();
+      net +=
+          chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    }
+
+    SearchNSort<int>::smallSortCutoff = 1u;
+    long double qs = timeSort(&SearchNSort<int>::quickSort, pSrc, reps, pArr,
+                              N, reps, compare);
+    long double is = timeSort(&SearchNSort<int>::insertionSort, pSrc, reps,
+                              pArr, N, reps, compare);
+
+    cout << "leaf\t" << N << "\t" << net / reps << "\t" << qs / reps << "\t"
+         << is / reps << endl;
+    if (net <= qs && net <= is) {
+      return N;
+    }
+    return LeafProbe<N - 4u>::run(pSrc, pArr, reps);
+  }
+};
+
+template <> struct LeafProbe<0u> {
+  static unsigned run(const int *, int *, unsigned) { return 0u; }
+};
+
+/*
+ * Smallest power-of-two size from which quickSort() beats mergeSort() on
+ * every larger size tried, or UINT_MAX if it doesn't win at the largest.
+ * The input arrays come from fillArray.
+ */
+unsigned quickCrossover(int powerCap, int (*comp)(const int &, const int &),
+                        FillFn fillArray, const char *pszLabel) {
+  using namespace std;
+
+  SearchNSort<int>::smallSortCutoff = 16u;
+  unsigned crossover = UINT_MAX;
+  for (int power = 6; power <= powerCap; power++) {
+    unsigned n = 1u << power;
+    unsigned reps = (1u << 22) / n;
+    unsigned pool = poolSize(n, reps);
+    int *pSrc = new int[(unsigned long long)n * pool];
+    int *pArr = new int[n];
+    for (unsigned i = 0u; i < pool; i++) {
+      fillArray(pSrc + (unsigned long long)i * n, n);
+    }
+
+    long double qs = timeSort(&SearchNSort<int>::quickSort, pSrc, pool, pArr,
+                              n, reps, comp);
+    long double ms = timeSort(&SearchNSort<int>::mergeSort, pSrc, pool, pArr,
+                              n, reps, comp);
+    cout << pszLabel << "\t" << n << "\t" << qs / reps << "\t" << ms / reps
+         << endl;
+
+    if (qs < ms) {
+      if (crossover == UINT_MAX) {
+        crossover = n;
+      }
+    } else {
+      crossover = UINT_MAX;
+    }
+
+    delete[] pSrc;
+    delete[] pArr;
+  }
+  return crossover;
+}
+
+/*
+ * Time quickSort() on organ-pipe input against quickSort() on random
+ * input of the same size. Returns the worst ratio of the two; much over 1
+ * means quickSort() has lost its guard against bad pivots.
+ */
+double pipeRatio(int powerCap, int (*comp)(const int &, const int &),
+                 const char *pszLabel) {
+  using namespace std;
+
+  SearchNSort<int>::smallSortCutoff = 16u;
+  double worst = 0.0;
+  for (int power = 6; power <= powerCap; power++) {
+    unsigned n = 1u << power;
+    unsigned reps = (1u << 22) / n;
+    unsigned pool = poolSize(n, reps);
+    int *pPipe = new int[n];
+    int *pRandom = new int[(unsigned long long)n * pool];
+    int *pArr = new int[n];
+    fillOrganPipe(pPipe, n);
+    fill(pRandom, n * pool);
+
+    long double pipe = timeSort(&SearchNSort<int>::quickSort, pPipe, 1u, pArr,
+                                n, reps, comp);
+    long double random = timeSort(&SearchNSort<int>::quickSort, pRandom,
+                                  pool, pArr, n, reps, comp);
+    cout << pszLabel << "\t" << n << "\t" << pipe / reps << "\t"
+         << random / reps << endl;
+    worst = max(worst, (double)(pipe / random));
+
+    delete[] pPipe;
+    delete[] pRandom;
+    delete[] pArr;
+  }
+  return worst;
+}
+
+int main(int argc, char **ppszArgs) {
+  using namespace std;
+
+  int powerCap = argc > 1 ? atoi(ppszArgs[1]) : 20;
+  if (powerCap < 6) {
+    cerr << "Usage: ./calibrate [maxPower]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));
+
+  SortProfile profile;
+
+  // sorting network against the recursive sorts on tiny arrays, with
+  // fresh data for every repetition
+  const unsigned reps = 1u << 14;
+  int *pSrc = new int[reps * maxNetworkSize];
+  int *pArr = new int[maxNetworkSize];
+  fill(pSrc, reps * maxNetworkSize);
+  cout << "\tn\tnet\tqs\tis" << endl;
+  profile.leafMax = LeafProbe<maxNetworkSize>::run(pSrc, pArr, reps);
+  delete[] pSrc;
+  delete[] pArr;
+
+  // insertionSort against mergeSort on presorted arrays
+  cout << "\tn\tis\tms" << endl;
+  profile.insertionMax = 0u;
+  for (unsigned n = 16u; n <= 8192u; n *= 2u) {
+    unsigned r = (1u << 20) / n;
+    unsigned pool = poolSize(n, r);
+    pSrc = new int[n * pool];
+    pArr = new int[n];
+    for (unsigned i = 0u; i < pool; i++) {
+      fillPresorted(pSrc + i * n, n);
+    }
+
+    long double is = timeSort(&SearchNSort<int>::insertionSort, pSrc, pool,
+                              pArr, n, r, compare);
+    long double ms = timeSort(&SearchNSort<int>::mergeSort, pSrc, pool, pArr,
+                              n, r, compare);
+    cout << "presort\t" << n << "\t" << is / r << "\t" << ms / r << endl;
+
+    delete[] pSrc;
+    delete[] pArr;
+
+    if (is > ms) {
+      break;
+    }
+    profile.insertionMax = n;
+  }
+
+  // quickSort against mergeSort on random arrays
+  cout << "\tn\tqs\tms" << endl;
+  profile.quickMinCompare = quickCrossover(powerCap, compare, fill, "compare");
+  profile.quickMinNatural =
+      quickCrossover(powerCap, &SearchNSort<int>::ascending, fill, "natural");
+
+  // sort() takes organ-pipe input for random input, so quickSort() must
+  // not fall apart on it
+  cout << "\tn\tpipe\trandom" << endl;
+  double ratio = pipeRatio(powerCap, compare, "pipe cmp");
+  ratio = std::max(
+      ratio, pipeRatio(powerCap, &SearchNSort<int>::ascending, "pipe nat"));
+  if (ratio > 2.0) {
+    cerr << "Warning: quickSort() is " << ratio
+         << "x slower on organ-pipe input than on random input" << endl;
+  }
+
+  // the same on keys drawn from only 16 values
+  cout << "\tn\tqs\tms" << endl;
+  profile.quickMinCompareDup =
+      quickCrossover(powerCap, compare, fillDuplicates, "dup cmp");
+  profile.quickMinNaturalDup =
+      quickCrossover(powerCap, &SearchNSort<int>::ascending, fillDuplicates,
+                     "dup nat");
+
+  // counting sort against mergeSort as the key range grows; the active
+  // profile lets counting sort take any range while measuring
+  cout << "\trange/n\tcs\tms" << endl;
+  const unsigned nCount = 1u << 16;
+  pSrc = new int[nCount];
+  pArr = new int[nCount];
+  SortProfile::active().countingRangeFactor = 1e9;
+  profile.countingRangeFactor = 0.0;
+  for (double factor = 0.25; factor <= 256.0; factor *= 2.0) {
+    int range = (int)(factor * nCount);
+    for (unsigned i = 0u; i < nCount; i++) {
+      pSrc[i] = rand() % range;
+    }
+
+    long double cs =
+        timeSort(countingSort, pSrc, 1u, pArr, nCount, 16u, compare);
+    long double ms = timeSort(&SearchNSort<int>::mergeSort, pSrc, 1u, pArr,
+                              nCount, 16u, &SearchNSort<int>::ascending);
+    cout << "count\t" << factor << "\t" << cs / 16 << "\t" << ms / 16 << endl;
+
+    if (cs > ms) {
+      break;
+    }
+    profile.countingRangeFactor = factor;
+  }
+  delete[] pSrc;
+  delete[] pArr;
+
+  const char *pszPath = SortProfile::defaultPath();
+  if (!profile.save(pszPath)) {
+    cerr << "Couldn't write " << pszPath << endl;
+    return EXIT_FAILURE;
+  }
+
+  cout << "Wrote " << pszPath << ":" << endl
+       << "leafMax " << profile.leafMax << endl
+       << "insertionMax " << profile.insertionMax << endl
+       << "presortedFraction " << profile.presortedFraction << endl
+       << "quickMinCompare " << profile.quickMinCompare << endl
+       << "quickMinNatural " << profile.quickMinNatural << endl
+       << "duplicateFraction " << profile.duplicateFraction << endl
+       << "quickMinCompareDup " << profile.quickMinCompareDup << endl
+       << "quickMinNaturalDup " << profile.quickMinNaturalDup << endl
+       << "countingRangeFactor " << profile.countingRangeFactor << endl;
+
+  return EXIT_SUCCESS;
+}
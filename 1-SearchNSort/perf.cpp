@@ -20,6 +20,15 @@ bool isSorted(int *pArr, unsigned n) {
   return true;
 }
 
+/*
+ * Organ-pipe data, rising to n / 2 and then falling.
+ */
+void fillOrganPipe(int *pA, int n) {
+  for (int i = 0; i < n; i++) {
+    pA[i] = i < n / 2 ? i : n - i;
+  }
+}
+
 void shuffle(int *pArr, unsigned n) {
   for (unsigned i = 0u; i < n; i++) {
     std::swap(pArr[i], pArr[rand() % n]);
@@ -33,7 +42,7 @@ int main(int argc, char **ppszArgs) {
 
   int powerCap = atoi(ppszArgs[1]);
 
-  cout << "p\tn\tbs\tis\tss\tms\tqs" << endl;
+  cout << "p\tn\tbs\tis\tss\tms\tqs\tsort\tpipe" << endl;
 
   int n = 256;
 
@@ -134,6 +143,43 @@ int main(int argc, char **ppszArgs) {
     dur /= 10;
     cout << dur << "\t";
 
+    // automatic sort test
+    dur = 0;
+    for (int i = 0; i < 10; i++) {
+      shuffle(pArr, n);
+      // do the sort
+      auto begin = chrono::high_resolution_clock::now();
+      SearchNSort<int>::sort(pArr, n, compare);
+      auto end = chrono::high_resolution_clock::now();
+      if (!isSorted(pArr, n)) {
+        cerr << "\n***** UNSORTED AFTER SORT!" << endl;
+        return EXIT_FAILURE;
+      }
+      dur +=
+          chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    }
+    dur /= 10;
+    cout << dur << "\t";
+
+    // automatic sort test on organ-pipe input, which looks random to
+    // sort() but gives quickSort() nothing but bad pivots
+    dur = 0;
+    for (int i = 0; i < 10; i++) {
+      fillOrganPipe(pArr, n);
+      // do the sort
+      auto begin = chrono::high_resolution_clock::now();
+      SearchNSort<int>::sort(pArr, n, compare);
+      auto end = chrono::high_resolution_clock::now();
+      if (!isSorted(pArr, n)) {
+        cerr << "\n***** UNSORTED AFTER ORGAN-PIPE SORT!" << endl;
+        return EXIT_FAILURE;
+      }
+      dur +=
+          chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    }
+    dur /= 10;
+    cout << dur << "\t";
+
     cout << endl;
     delete[] pArr;
 
@@ -0,0 +1,136 @@
+#include "CountingSort.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+int compare(const int &x, const int &y) { return (x > y) - (x < y); }
+
+void fill(int *pA, unsigned n, int range) {
+  for (unsigned i = 0u; i < n; i++) {
+    pA[i] = rand() % range - range / 2;
+  }
+}
+
+bool isSorted(int *pArr, unsigned n) {
+  for (unsigned i = 0u; i + 1u < n; i++) {
+    if (pArr[i] > pArr[i + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Check a key+payload sort whose payloads started out as the positions of
+ * their keys in pOrig: each payload must still point at its key, and equal
+ * keys must keep their payloads in increasing order.
+ */
+bool isStable(const int *pKeys, const unsigned *pPayload, const int *pOrig,
+              unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    if (pOrig[pPayload[i]] != pKeys[i]) {
+      return false;
+    }
+    if (i > 0u && pKeys[i - 1] == pKeys[i] && pPayload[i - 1] > pPayload[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void shuffle(int *pArr, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    std::swap(pArr[i], pArr[rand() % n]);
+  }
+}
+
+/*
+ * Sorts under test. Each takes the keys, a payload array, and the key
+ * range.
+ */
+void quick(int *pKeys, unsigned *, unsigned n, int, int) {
+  SearchNSort<int>::quickSort(pKeys, n, compare);
+}
+
+void autoSort(int *pKeys, unsigned *, unsigned n, int, int) {
+  SearchNSort<int>::sort(pKeys, n, SearchNSort<int>::ascending);
+}
+
+void keys(int *pKeys, unsigned *, unsigned n, int min, int max) {
+  CountingSort<int>::sort(pKeys, n, min, max);
+}
+
+void keysParallel(int *pKeys, unsigned *, unsigned n, int min, int max) {
+  CountingSort<int>::sort(pKeys, n, min, max, 0u);
+}
+
+void payload(int *pKeys, unsigned *pPayload, unsigned n, int min, int max) {
+  CountingSort<int>::sort(pKeys, pPayload, n, min, max);
+}
+
+typedef void (*SortFn)(int *, unsigned *, unsigned, int, int);
+
+int main(int argc, char **ppszArgs) {
+  using namespace std;
+
+  if (argc != 2) {
+    cerr << "Usage: ./perfcount maxPower" << endl;
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));
+
+  int powerCap = atoi(ppszArgs[1]);
+  const int ranges[] = {16, 1 << 16};
+  const SortFn sorts[] = {quick, autoSort, keys, keysParallel, payload};
+
+  for (int range : ranges) {
+    cout << "keys in [" << -range / 2 << ", " << range - range / 2 - 1
+         << "]" << endl;
+    cout << "p\tn\tqs\tsort\tcs\tcs par\tcs pay" << endl;
+
+    unsigned n = 256u;
+    for (int power = 8; power <= powerCap; power++) {
+      int *pArr = new int[n];
+      int *pOrig = new int[n];
+      unsigned *pPayload = new unsigned[n];
+      fill(pArr, n, range);
+
+      cout << power << "\t" << n;
+      for (SortFn sort : sorts) {
+        long double dur = 0;
+        for (int i = 0; i < 10; i++) {
+          shuffle(pArr, n);
+          std::copy(pArr, pArr + n, pOrig);
+          for (unsigned j = 0u; j < n; j++) {
+            pPayload[j] = j;
+          }
+          auto begin = chrono::high_resolution_clock::now();
+          sort(pArr, pPayload, n, -range / 2, range - range / 2 - 1);
+          auto end = chrono::high_resolution_clock::now();
+          if (!isSorted(pArr, n)) {
+            cerr << "\n***** UNSORTED!" << endl;
+            return EXIT_FAILURE;
+          }
+          if (sort == payload && !isStable(pArr, pPayload, pOrig, n)) {
+            cerr << "\n***** PAYLOADS OUT OF PLACE!" << endl;
+            return EXIT_FAILURE;
+          }
+          dur += chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+                     .count();
+        }
+        cout << "\t" << dur / 10;
+      }
+      cout << endl;
+
+      delete[] pArr;
+      delete[] pOrig;
+      delete[] pPayload;
+      n *= 2u;
+    }
+    cout << endl;
+  }
+
+  return EXIT_SUCCESS;
+}
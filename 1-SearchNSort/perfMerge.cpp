@@ -0,0 +1,114 @@
+#include "SearchNSort.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+/*
+ * Comparison function that SearchNSort can't see through, so mergeSort()
+ * uses its scalar merge.
+ */
+template <class T> int compare(const T &x, const T &y) {
+  return (x > y) - (x < y);
+}
+
+template <class T> void fill(T *pA, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    pA[i] = static_cast<T>(rand()) - RAND_MAX / 2;
+  }
+}
+
+template <class T> bool isSorted(T *pArr, unsigned n) {
+  for (unsigned i = 0u; i + 1u < n; i++) {
+    if (pArr[i] > pArr[i + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class T> void shuffle(T *pArr, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    std::swap(pArr[i], pArr[rand() % n]);
+  }
+}
+
+/*
+ * Average time in ns of ten mergeSort() calls on a shuffled array, or -1
+ * if a sort fails.
+ */
+template <class T>
+long double timeMergeSort(T *pArr, unsigned n,
+                          int (*comp)(const T &x, const T &y)) {
+  using namespace std;
+
+  long double dur = 0;
+  for (int i = 0; i < 10; i++) {
+    shuffle(pArr, n);
+    auto begin = chrono::high_resolution_clock::now();
+    SearchNSort<T>::mergeSort(pArr, n, comp);
+    auto end = chrono::high_resolution_clock::now();
+    if (!isSorted(pArr, n)) {
+      return -1;
+    }
+    dur += chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  }
+  return dur / 10;
+}
+
+/*
+ * Print scalar and vectorized mergeSort() times for one element type,
+ * both without network leaves so only the merge differs, then the
+ * vectorized time with the default network leaves as well.
+ */
+template <class T> bool row(unsigned n) {
+  T *pArr = new T[n];
+  fill(pArr, n);
+
+  unsigned cutoff = SearchNSort<T>::smallSortCutoff;
+  SearchNSort<T>::smallSortCutoff = 1u;
+  long double scalar = timeMergeSort(pArr, n, compare<T>);
+  long double simd = timeMergeSort(pArr, n, SearchNSort<T>::ascending);
+  SearchNSort<T>::smallSortCutoff = cutoff;
+  long double leaves = timeMergeSort(pArr, n, SearchNSort<T>::ascending);
+
+  delete[] pArr;
+
+  std::cout << "\t" << scalar << "\t" << simd << "\t" << leaves;
+  return scalar >= 0 && simd >= 0 && leaves >= 0;
+}
+
+int main(int argc, char **ppszArgs) {
+  using namespace std;
+
+  if (argc != 2) {
+    cerr << "Usage: ./perfmerge maxPower" << endl;
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));
+
+  int powerCap = atoi(ppszArgs[1]);
+
+  // "ms" columns use a plain comparison function, "asc" columns use
+  // SearchNSort<T>::ascending and get the vectorized merge; neither uses
+  // network leaves. "+net" columns add the network leaves to "asc"
+  cout << "vector merge: " << simdMergeTarget() << endl;
+  cout << "p\tn\tint ms\tasc\t+net\tflt ms\tasc\t+net\tdbl ms\tasc\t+net"
+       << "\ti64 ms\tasc\t+net" << endl;
+
+  unsigned n = 256u;
+  for (int power = 8; power <= powerCap; power++) {
+    cout << power << "\t" << n;
+    if (!row<int32_t>(n) || !row<float>(n) || !row<double>(n) ||
+        !row<int64_t>(n)) {
+      cerr << "\n***** UNSORTED AFTER MERGESORT!" << endl;
+      return EXIT_FAILURE;
+    }
+    cout << endl;
+
+    n *= 2u;
+  }
+
+  return EXIT_SUCCESS;
+}
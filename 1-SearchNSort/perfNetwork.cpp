@@ -0,0 +1,142 @@
+#include "SearchNSort.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+int compare(const int &x, const int &y) { return (x - y); }
+
+typedef void (*SortFn)(int *, unsigned, int (*)(const int &, const int &));
+
+void fill(int *pA, int n) {
+  for (int i = 0; i < n; i++) {
+    pA[i] = rand();
+  }
+}
+
+bool isSorted(int *pArr, unsigned n) {
+  for (unsigned i = 0u; i + 1u < n; i++) {
+    if (pArr[i] > pArr[i + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void shuffle(int *pArr, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    std::swap(pArr[i], pArr[rand() % n]);
+  }
+}
+
+/*
+ * Average time in ns of ten sorts of a shuffled array, or -1 if a sort
+ * fails.
+ */
+long double timeSort(SortFn sort, int *pArr, unsigned n,
+                     int (*comp)(const int &, const int &),
+                     unsigned cutoff) {
+  using namespace std;
+
+  SearchNSort<int>::smallSortCutoff = cutoff;
+
+  long double dur = 0;
+  for (int i = 0; i < 10; i++) {
+    shuffle(pArr, n);
+    auto begin = chrono::high_resolution_clock::now();
+    sort(pArr, n, comp);
+    auto end = chrono::high_resolution_clock::now();
+    if (!isSorted(pArr, n)) {
+      return -1;
+    }
+    dur += chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  }
+  return dur / 10;
+}
+
+/*
+ * Average time in ns to sort reps arrays of N elements with
+ * insertionSort() or sortSmall<N>().
+ */
+template <unsigned N> void timeLeaf(int *pArr, unsigned reps) {
+  using namespace std;
+
+  fill(pArr, N * reps);
+  auto begin = chrono::high_resolution_clock::now();
+  for (unsigned r = 0u; r < reps; r++) {
+    SearchNSort<int>::insertionSort(pArr + r * N, N, compare);
+  }
+  auto end = chrono::high_resolution_clock::now();
+  long double is =
+      chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+  fill(pArr, N * reps);
+  begin = chrono::high_resolution_clock::now();
+  for (unsigned r = 0u; r < reps; r++) {
+    SearchNSort<int>::sortSmall<N>(pArr + r * N);
+  }
+  end = chrono::high_resolution_clock::now();
+  long double net =
+      chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+  cout << N << "\t" << is / reps << "\t" << net / reps << endl;
+}
+
+int main(int argc, char **ppszArgs) {
+  using namespace std;
+
+  if (argc != 2) {
+    cerr << "Usage: ./perfnet maxPower" << endl;
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));
+
+  int powerCap = atoi(ppszArgs[1]);
+  const unsigned cutoff = SearchNSort<int>::smallSortCutoff;
+  const SortFn ms = &SearchNSort<int>::mergeSort;
+  const SortFn qs = &SearchNSort<int>::quickSort;
+  int (*const asc)(const int &, const int &) = &SearchNSort<int>::ascending;
+
+  // leaf sorts on their own
+  const unsigned reps = 1u << 16;
+  int *pArr = new int[32u * reps];
+  cout << "N\tis\tnet" << endl;
+  timeLeaf<4>(pArr, reps);
+  timeLeaf<8>(pArr, reps);
+  timeLeaf<16>(pArr, reps);
+  timeLeaf<32>(pArr, reps);
+  delete[] pArr;
+  cout << endl;
+
+  // whole sorts with networks off (cutoff 1) and on; "asc" columns use
+  // SearchNSort<int>::ascending instead of compare()
+  cout << "p\tn\tms asc\t+net\tqs\t+net\tqs asc\t+net" << endl;
+
+  unsigned n = 256u;
+  for (int power = 8; power <= powerCap; power++) {
+    pArr = new int[n];
+    fill(pArr, n);
+
+    long double dur[6] = {timeSort(ms, pArr, n, asc, 1u),
+                          timeSort(ms, pArr, n, asc, cutoff),
+                          timeSort(qs, pArr, n, compare, 1u),
+                          timeSort(qs, pArr, n, compare, cutoff),
+                          timeSort(qs, pArr, n, asc, 1u),
+                          timeSort(qs, pArr, n, asc, cutoff)};
+
+    cout << power << "\t" << n;
+    for (int i = 0; i < 6; i++) {
+      if (dur[i] < 0) {
+        cerr << "\n***** UNSORTED!" << endl;
+        return EXIT_FAILURE;
+      }
+      cout << "\t" << dur[i];
+    }
+    cout << endl;
+
+    delete[] pArr;
+    n *= 2u;
+  }
+
+  return EXIT_SUCCESS;
+}
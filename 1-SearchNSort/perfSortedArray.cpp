@@ -0,0 +1,139 @@
+#include "SortedArray.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+int compare(const int &x, const int &y) { return (x > y) - (x < y); }
+
+void fill(int *pA, int n) {
+  for (int i = 0; i < n; i++) {
+    pA[i] = rand();
+  }
+}
+
+long double elapsed(std::chrono::high_resolution_clock::time_point begin,
+                    std::chrono::high_resolution_clock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+      .count();
+}
+
+int main(int argc, char **ppszArgs) {
+  using namespace std;
+
+  if (argc != 2) {
+    cerr << "Usage: ./perfsa power" << endl;
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));
+
+  int power = atoi(ppszArgs[1]);
+  int n = 1 << power;
+  const int nUpdates = 1 << 16;
+  const int nLookups = 1 << 20;
+
+  int *pArr = new int[n];
+  fill(pArr, n);
+
+  // random updates: even positions insert fresh keys, odd positions
+  // remove keys from the initial data
+  int *pUpdates = new int[nUpdates];
+  for (int i = 0; i < nUpdates; i++) {
+    pUpdates[i] = (i % 2 == 0) ? rand() : pArr[rand() % n];
+  }
+
+  // lookups hit and miss about equally often
+  int *pLookups = new int[nLookups];
+  for (int i = 0; i < nLookups; i++) {
+    pLookups[i] = (i % 2 == 0) ? rand() : pArr[rand() % n];
+  }
+
+  cout << "n = " << n << ", rates in operations per second" << endl;
+  cout << "batch\tupd/s\tlook/s\tmerges\twamp\tresort upd/s" << endl;
+
+  for (unsigned batch = 16u; batch <= 4096u; batch *= 4u) {
+    SortedArray<int> sa(compare, batch);
+    sa.assign(pArr, n);
+
+    auto begin = chrono::high_resolution_clock::now();
+    for (int i = 0; i < nUpdates; i++) {
+      if (i % 2 == 0) {
+        sa.insert(pUpdates[i]);
+      } else {
+        sa.remove(pUpdates[i]);
+      }
+    }
+    auto end = chrono::high_resolution_clock::now();
+    long double updRate = nUpdates / (elapsed(begin, end) / 1e9);
+
+    // leave the log half full so lookups exercise both parts
+    for (unsigned i = 0u; i < batch / 2u; i++) {
+      sa.insert(rand());
+    }
+
+    unsigned found = 0u;
+    begin = chrono::high_resolution_clock::now();
+    for (int i = 0; i < nLookups; i++) {
+      found += sa.contains(pLookups[i]);
+    }
+    end = chrono::high_resolution_clock::now();
+    long double lookRate = nLookups / (elapsed(begin, end) / 1e9);
+
+    const int *pSorted = sa.data();
+    for (unsigned i = 1u; i < sa.size(); i++) {
+      if (pSorted[i - 1] >= pSorted[i]) {
+        cerr << "\n***** UNSORTED SORTEDARRAY!" << endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    // baseline: what callers do today with the same update stream. Each
+    // batch finds its removals with binarySearch() and drops them, appends
+    // its inserts, and quickSort()s the whole array again. This is slow,
+    // so only a few batches are timed
+    vector<int> v(pArr, pArr + n);
+    SearchNSort<int>::quickSort(v.data(), v.size(), compare);
+    vector<char> removed;
+    const int nBatches = 4;
+    begin = chrono::high_resolution_clock::now();
+    for (int b = 0; b < nBatches; b++) {
+      removed.assign(v.size(), 0);
+      vector<int> inserts;
+      for (unsigned i = 0u; i < batch; i++) {
+        int u = (b * batch + i) % nUpdates;
+        if (u % 2 == 0) {
+          inserts.push_back(pUpdates[u]);
+        } else {
+          int k = SearchNSort<int>::binarySearch(v.data(), v.size(),
+                                                 pUpdates[u], compare);
+          if (k >= 0) {
+            removed[k] = 1;
+          }
+        }
+      }
+
+      unsigned kept = 0u;
+      for (unsigned i = 0u; i < v.size(); i++) {
+        if (!removed[i]) {
+          v[kept++] = v[i];
+        }
+      }
+      v.resize(kept);
+      v.insert(v.end(), inserts.begin(), inserts.end());
+      SearchNSort<int>::quickSort(v.data(), v.size(), compare);
+    }
+    end = chrono::high_resolution_clock::now();
+    long double resortRate = nBatches * batch / (elapsed(begin, end) / 1e9);
+
+    cout << batch << "\t" << updRate << "\t" << lookRate << "\t"
+         << sa.merges() << "\t" << sa.writeAmplification() << "\t"
+         << resortRate << "\t(" << found << " found)" << endl;
+  }
+
+  delete[] pArr;
+  delete[] pUpdates;
+  delete[] pLookups;
+
+  return EXIT_SUCCESS;
+}
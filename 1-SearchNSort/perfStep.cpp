@@ -0,0 +1,132 @@
+#include "ResumableSort.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+int compare(const int &x, const int &y) { return (x > y) - (x < y); }
+
+void fill(int *pA, unsigned n) {
+  for (unsigned i = 0u; i < n; i++) {
+    pA[i] = rand();
+  }
+}
+
+bool isSorted(int *pArr, unsigned n) {
+  for (unsigned i = 0u; i + 1u < n; i++) {
+    if (pArr[i] > pArr[i + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Sort a copy of pSrc one step at a time, printing the number of steps,
+ * the p50 / p99 / p99.9 / max latency of a step in ns, and the total time
+ * in ns. Budget is an operation count or a std::chrono::nanoseconds.
+ */
+template <class Budget>
+bool timeSteps(const int *pSrc, int *pArr, unsigned n,
+               ResumableSort<int>::Algorithm algorithm, Budget budget) {
+  using namespace std;
+
+  copy(pSrc, pSrc + n, pArr);
+  ResumableSort<int> sorter(pArr, n, compare, algorithm);
+
+  vector<long long> steps;
+  bool done = false;
+  while (!done) {
+    auto begin = chrono::high_resolution_clock::now();
+    done = sorter.step(budget);
+    auto end = chrono::high_resolution_clock::now();
+    steps.push_back(
+        chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+  }
+  if (!isSorted(pArr, n)) {
+    cerr << "\n***** UNSORTED!" << endl;
+    return false;
+  }
+
+  long double total = 0;
+  for (long long ns : steps) {
+    total += ns;
+  }
+  sort(steps.begin(), steps.end());
+  size_t last = steps.size() - 1u;
+  cout << "\t" << steps.size() << "\t" << steps[last * 50u / 100u] << "\t"
+       << steps[last * 99u / 100u] << "\t" << steps[last * 999u / 1000u]
+       << "\t" << steps[last] << "\t" << total;
+  return true;
+}
+
+/*
+ * Time to sort a copy of pSrc in one call, in ns.
+ */
+long double timeOneShot(const int *pSrc, int *pArr, unsigned n,
+                        ResumableSort<int>::Algorithm algorithm) {
+  using namespace std;
+
+  copy(pSrc, pSrc + n, pArr);
+  auto begin = chrono::high_resolution_clock::now();
+  if (algorithm == ResumableSort<int>::QUICK) {
+    SearchNSort<int>::quickSort(pArr, n, compare);
+  } else {
+    SearchNSort<int>::mergeSort(pArr, n, compare);
+  }
+  auto end = chrono::high_resolution_clock::now();
+  return chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+}
+
+int main(int argc, char **ppszArgs) {
+  using namespace std;
+
+  if (argc != 2) {
+    cerr << "Usage: ./perfstep power" << endl;
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));
+
+  unsigned n = 1u << atoi(ppszArgs[1]);
+  int *pSrc = new int[n];
+  int *pArr = new int[n];
+  fill(pSrc, n);
+
+  const ResumableSort<int>::Algorithm algorithms[] = {
+      ResumableSort<int>::QUICK, ResumableSort<int>::MERGE};
+  const char *names[] = {"qs", "ms"};
+  const unsigned long long opBudgets[] = {1000ull, 10000ull, 100000ull};
+  const long long nsBudgets[] = {10000ll, 100000ll, 1000000ll};
+
+  cout << "n = " << n << "; latencies in ns" << endl;
+  for (int a = 0; a < 2; a++) {
+    cout << names[a] << " one shot\t" << timeOneShot(pSrc, pArr, n,
+                                                     algorithms[a])
+         << endl;
+    cout << "budget\tsteps\tp50\tp99\tp99.9\tmax\ttotal" << endl;
+
+    for (unsigned long long ops : opBudgets) {
+      cout << ops << " ops";
+      if (!timeSteps(pSrc, pArr, n, algorithms[a], ops)) {
+        return EXIT_FAILURE;
+      }
+      cout << endl;
+    }
+    for (long long ns : nsBudgets) {
+      cout << ns << " ns";
+      if (!timeSteps(pSrc, pArr, n, algorithms[a],
+                     std::chrono::nanoseconds(ns))) {
+        return EXIT_FAILURE;
+      }
+      cout << endl;
+    }
+    cout << endl;
+  }
+
+  delete[] pSrc;
+  delete[] pArr;
+
+  return EXIT_SUCCESS;
+}